@@ -103,14 +103,20 @@ typedef unsigned char      aes_08t;
 #define aes_rval    aes_ret __declspec(dllexport) _stdcall
 #endif
 
+/* ni is set when ni_ks holds the round keys for the AES-NI code in aesni.c */
+
 typedef struct
 {   aes_32t ks[KS_LENGTH];
     aes_32t rn;
+    aes_32t ni;
+    aes_08t ni_ks[AES_BLOCK_SIZE * 15];
 } csql_aes_encrypt_ctx;
 
 typedef struct
 {   aes_32t ks[KS_LENGTH];
     aes_32t rn;
+    aes_32t ni;
+    aes_08t ni_ks[AES_BLOCK_SIZE * 15];
 } csql_aes_decrypt_ctx;
 
 /* This routine must be called before first use if non-static       */
@@ -163,6 +169,16 @@ aes_rval csql_aes_decrypt_key(const unsigned char *in_key, int key_len, csql_aes
 aes_rval csql_aes_decrypt(const unsigned char *in_blk,  unsigned char *out_blk, const csql_aes_decrypt_ctx cx[1]);
 #endif
 
+/* AES-NI, see aesni.c; the key functions above fill in the round keys when it is supported */
+
+int  csql_aesni_supported(void);
+void csql_aesni_encrypt_key(csql_aes_encrypt_ctx cx[1]);
+void csql_aesni_decrypt_key(const unsigned char *in_key, int key_len, csql_aes_decrypt_ctx cx[1]);
+void csql_aesni_encrypt(const unsigned char *in_blk, unsigned char *out_blk, const csql_aes_encrypt_ctx cx[1]);
+void csql_aesni_decrypt(const unsigned char *in_blk, unsigned char *out_blk, const csql_aes_decrypt_ctx cx[1]);
+void csql_aesni_cbc_encrypt(unsigned char *buf, int nblocks, const unsigned char *iv, const csql_aes_encrypt_ctx cx[1]);
+void csql_aesni_cbc_decrypt(unsigned char *buf, int nblocks, const csql_aes_decrypt_ctx cx[1]);
+
 #if defined(__cplusplus)
 }
 #endif
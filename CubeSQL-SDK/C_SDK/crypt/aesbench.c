@@ -0,0 +1,116 @@
+/*
+ Microbenchmark of the session encryption, comparing the table driven AES of
+ aescrypt.c with the AES-NI code of aesni.c on encrypt_buffer / decrypt_buffer.
+ It first checks that both produce identical output for every buffer length
+ up to a few blocks, then reports the throughput of both paths.
+
+ It is not part of the addon build, compile it from CubeSQL-SDK/C_SDK with:
+
+ cc -O2 -DCUBESQL_DISABLE_SSL_ENCRYPTION -I. -Icrypt -o aesbench crypt/aesbench.c cubesql.c \
+    crypt/aescrypt.c crypt/aeskey.c crypt/aesni.c crypt/aestab.c crypt/base64.c crypt/pseudorandom.c crypt/sha1.c -lz
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cubesql.h"
+#include "csql.h"
+
+#define BENCH_SIZE      (4 * 1024 * 1024)
+#define BENCH_SECONDS   1.0
+
+static double now (void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int check (csql_aes_encrypt_ctx *enc, csql_aes_decrypt_ctx *dec, int ni) {
+	char plain[200], random[BLOCK_LEN], random_table[BLOCK_LEN], random_ni[BLOCK_LEN], a[200], b[200];
+	csql_aes_encrypt_ctx enc_table = *enc;
+	csql_aes_decrypt_ctx dec_table = *dec;
+	int dim, i;
+
+	enc_table.ni = 0;
+	dec_table.ni = 0;
+	for (i = 0; i < (int)sizeof(plain); ++i) plain[i] = (char)(rand() & 0xff);
+	for (i = 0; i < BLOCK_LEN; ++i) random[i] = (char)(rand() & 0xff);
+
+	for (dim = 1; dim < (int)sizeof(plain); ++dim) {
+		memcpy(a, plain, dim); memcpy(random_table, random, BLOCK_LEN);
+		memcpy(b, plain, dim); memcpy(random_ni, random, BLOCK_LEN);
+		encrypt_buffer(a, dim, random_table, &enc_table);
+		encrypt_buffer(b, dim, random_ni, enc);
+		if (memcmp(a, b, dim) != 0 || memcmp(random_table, random_ni, BLOCK_LEN) != 0) {
+			printf("encrypt_buffer differs for %d bytes\n", dim);
+			return 0;
+		}
+
+		// decrypt_buffer takes the random pool followed by the encrypted buffer
+		char wire[BLOCK_LEN + 200];
+		memcpy(wire, random_table, BLOCK_LEN);
+		memcpy(wire + BLOCK_LEN, a, dim);
+		decrypt_buffer(wire, dim + BLOCK_LEN, (ni) ? dec : &dec_table);
+		if (memcmp(wire, plain, dim) != 0) {
+			printf("decrypt_buffer does not round trip %d bytes\n", dim);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static double throughput (char *buffer, int size, char *random, void *ctx, int encrypt) {
+	double start = now(), elapsed;
+	long long total = 0;
+
+	do {
+		if (encrypt) encrypt_buffer(buffer, size, random, (csql_aes_encrypt_ctx *)ctx);
+		else decrypt_buffer(buffer, size + BLOCK_LEN, (csql_aes_decrypt_ctx *)ctx);
+		total += size;
+		elapsed = now() - start;
+	} while (elapsed < BENCH_SECONDS);
+
+	return (total / (1024.0 * 1024.0)) / elapsed;
+}
+
+int main (void) {
+	static const int key_lengths[] = {16, 24, 32};
+	static const int sizes[] = {64, 4 * 1024, BENCH_SIZE};
+	unsigned char key[32];
+	char random[BLOCK_LEN];
+	char *buffer = (char *) malloc(BENCH_SIZE + BLOCK_LEN + 1);
+	int i, k, n;
+
+	if (buffer == NULL) return 1;
+	csql_gen_tabs();
+	for (i = 0; i < 32; ++i) key[i] = (unsigned char)(i * 7 + 1);
+	for (i = 0; i < BLOCK_LEN; ++i) random[i] = (char)i;
+	for (i = 0; i < BENCH_SIZE + BLOCK_LEN; ++i) buffer[i] = (char)(i & 0xff);
+
+	printf("AES-NI %s\n", csql_aesni_supported() ? "supported" : "not supported, only the table code is measured");
+
+	for (k = 0; k < 3; ++k) {
+		csql_aes_encrypt_ctx enc, enc_table;
+		csql_aes_decrypt_ctx dec, dec_table;
+
+		csql_aes_encrypt_key(key, key_lengths[k], &enc);
+		csql_aes_decrypt_key(key, key_lengths[k], &dec);
+		enc_table = enc; enc_table.ni = 0;
+		dec_table = dec; dec_table.ni = 0;
+
+		if (!check(&enc, &dec, kFALSE) || !check(&enc, &dec, kTRUE)) return 1;
+
+		for (n = 0; n < 3; ++n) {
+			int size = sizes[n];
+			printf("AES%d %8d bytes  encrypt table %8.1f MB/s", key_lengths[k] * 8, size, throughput(buffer, size, random, &enc_table, kTRUE));
+			if (enc.ni) printf("  aes-ni %8.1f MB/s", throughput(buffer, size, random, &enc, kTRUE));
+			printf("  decrypt table %8.1f MB/s", throughput(buffer, size, random, &dec_table, kFALSE));
+			if (dec.ni) printf("  aes-ni %8.1f MB/s", throughput(buffer, size, random, &dec, kFALSE));
+			printf("\n");
+		}
+	}
+
+	free(buffer);
+	return 0;
+}
@@ -117,6 +117,16 @@ aes_rval csql_aes_encrypt(const unsigned char *in,
         return aes_error;
 #endif
 
+    if( cx->ni )
+    {
+        csql_aesni_encrypt(in, out, cx);
+#if defined( AES_ERR_CHK )
+        return aes_good;
+#else
+        return;
+#endif
+    }
+
     state_in(b0, in, kp);
 
 #if (ENC_UNROLL == FULL)
@@ -238,6 +248,16 @@ aes_rval csql_aes_decrypt(const unsigned char *in,
         return aes_error;
 #endif
 
+    if( cx->ni )
+    {
+        csql_aesni_decrypt(in, out, cx);
+#if defined( AES_ERR_CHK )
+        return aes_good;
+#else
+        return;
+#endif
+    }
+
     state_in(b0, in, kp);
 
 #if (DEC_UNROLL == FULL)
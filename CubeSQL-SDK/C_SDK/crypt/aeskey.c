@@ -195,19 +195,26 @@ aes_rval csql_aes_encrypt_key256(const unsigned char *key, csql_aes_encrypt_ctx
 
 aes_rval csql_aes_encrypt_key(const unsigned char *key, int key_len, csql_aes_encrypt_ctx cx[1])
 {
+    cx->ni = 0;
     switch(key_len)
     {
 #if defined( AES_ERR_CHK )
-    case 16: case 128: return csql_aes_encrypt_key128(key, cx);
-    case 24: case 192: return csql_aes_encrypt_key192(key, cx);
-    case 32: case 256: return csql_aes_encrypt_key256(key, cx);
+    case 16: case 128: if(csql_aes_encrypt_key128(key, cx) != aes_good) return aes_error; break;
+    case 24: case 192: if(csql_aes_encrypt_key192(key, cx) != aes_good) return aes_error; break;
+    case 32: case 256: if(csql_aes_encrypt_key256(key, cx) != aes_good) return aes_error; break;
     default: return aes_error;
 #else
-    case 16: case 128: csql_aes_encrypt_key128(key, cx); return;
-    case 24: case 192: csql_aes_encrypt_key192(key, cx); return;
-    case 32: case 256: csql_aes_encrypt_key256(key, cx); return;
+    case 16: case 128: csql_aes_encrypt_key128(key, cx); break;
+    case 24: case 192: csql_aes_encrypt_key192(key, cx); break;
+    case 32: case 256: csql_aes_encrypt_key256(key, cx); break;
+    default: return;
 #endif
     }
+
+    csql_aesni_encrypt_key(cx);
+#if defined( AES_ERR_CHK )
+    return aes_good;
+#endif
 }
 
 #endif
@@ -431,19 +438,26 @@ aes_rval csql_aes_decrypt_key256(const unsigned char *key, csql_aes_decrypt_ctx
 
 aes_rval csql_aes_decrypt_key(const unsigned char *key, int key_len, csql_aes_decrypt_ctx cx[1])
 {
+    cx->ni = 0;
     switch(key_len)
     {
 #if defined( AES_ERR_CHK )
-    case 16: case 128: return csql_aes_decrypt_key128(key, cx);
-    case 24: case 192: return csql_aes_decrypt_key192(key, cx);
-    case 32: case 256: return csql_aes_decrypt_key256(key, cx);
+    case 16: case 128: if(csql_aes_decrypt_key128(key, cx) != aes_good) return aes_error; break;
+    case 24: case 192: if(csql_aes_decrypt_key192(key, cx) != aes_good) return aes_error; break;
+    case 32: case 256: if(csql_aes_decrypt_key256(key, cx) != aes_good) return aes_error; break;
     default: return aes_error;
 #else
-    case 16: case 128: csql_aes_decrypt_key128(key, cx); return;
-    case 24: case 192: csql_aes_decrypt_key192(key, cx); return;
-    case 32: case 256: csql_aes_decrypt_key256(key, cx); return;
+    case 16: case 128: csql_aes_decrypt_key128(key, cx); break;
+    case 24: case 192: csql_aes_decrypt_key192(key, cx); break;
+    case 32: case 256: csql_aes_decrypt_key256(key, cx); break;
+    default: return;
 #endif
     }
+
+    csql_aesni_decrypt_key(key, key_len, cx);
+#if defined( AES_ERR_CHK )
+    return aes_good;
+#endif
 }
 
 #endif
@@ -0,0 +1,207 @@
+/*
+ AES-NI implementation of the AES block functions and of the CBC loops used
+ by encrypt_buffer / decrypt_buffer in cubesql.c.
+
+ The round keys are derived from the key schedule built by aeskey.c, so both
+ implementations produce exactly the same output. Whether the processor
+ supports AES-NI is checked once at runtime; when it does not, or on other
+ architectures, the ni flag of the contexts stays 0 and the table driven code
+ in aescrypt.c is used. Define CUBESQL_DISABLE_AESNI to leave it out entirely.
+*/
+
+#include <string.h>
+#include "aesopt.h"
+
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) && !defined(CUBESQL_DISABLE_AESNI)
+#define CSQL_AESNI
+#endif
+
+#if defined(CSQL_AESNI)
+
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AESNI_TARGET
+#else
+#include <cpuid.h>
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+#endif
+
+/* blocks decrypted per iteration of csql_aesni_cbc_decrypt, independent blocks keep the AES unit busy */
+#define AESNI_PARALLEL  8
+
+int csql_aesni_supported(void)
+{   static int supported = -1;
+
+    if(supported == -1)
+    {   unsigned int ecx, edx;
+#if defined(_MSC_VER)
+        int regs[4];
+        __cpuid(regs, 1);
+        ecx = (unsigned int)regs[2];
+        edx = (unsigned int)regs[3];
+#else
+        unsigned int eax, ebx;
+        if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+            ecx = edx = 0;
+#endif
+        /* AES is bit 25 of ecx, SSE2 bit 26 of edx */
+        supported = ((ecx >> 25) & 1) && ((edx >> 26) & 1);
+    }
+    return supported;
+}
+
+void csql_aesni_encrypt_key(csql_aes_encrypt_ctx cx[1])
+{   int i;
+
+    cx->ni = 0;
+    if(!csql_aesni_supported() || (cx->rn != 10 && cx->rn != 12 && cx->rn != 14))
+        return;
+
+    /* the round key bytes, in the byte order the schedule words were built with */
+    for(i = 0; i < (int)(cx->rn + 1) * N_COLS; ++i)
+    {
+        cx->ni_ks[4 * i + 0] = bval(cx->ks[i], 0);
+        cx->ni_ks[4 * i + 1] = bval(cx->ks[i], 1);
+        cx->ni_ks[4 * i + 2] = bval(cx->ks[i], 2);
+        cx->ni_ks[4 * i + 3] = bval(cx->ks[i], 3);
+    }
+    cx->ni = 1;
+}
+
+AESNI_TARGET static void aesni_inverse_keys(aes_08t *dk, const aes_08t *ek, int rn)
+{   int i;
+
+    /* equivalent inverse cipher: encryption round keys in reverse, the inner ones through InvMixColumns */
+    _mm_storeu_si128((__m128i *)dk, _mm_loadu_si128((const __m128i *)(ek + 16 * rn)));
+    for(i = 1; i < rn; ++i)
+        _mm_storeu_si128((__m128i *)(dk + 16 * i), _mm_aesimc_si128(_mm_loadu_si128((const __m128i *)(ek + 16 * (rn - i)))));
+    _mm_storeu_si128((__m128i *)(dk + 16 * rn), _mm_loadu_si128((const __m128i *)ek));
+}
+
+void csql_aesni_decrypt_key(const unsigned char *in_key, int key_len, csql_aes_decrypt_ctx cx[1])
+{   csql_aes_encrypt_ctx ecx[1];
+
+    cx->ni = 0;
+    if(!csql_aesni_supported())
+        return;
+
+    /* the decryption schedule of aeskey.c is in a table specific form, start from the encryption one */
+    memset(ecx, 0, sizeof(ecx));
+    csql_aes_encrypt_key(in_key, key_len, ecx);
+    if(!ecx->ni || ecx->rn != cx->rn)
+        return;
+
+    aesni_inverse_keys(cx->ni_ks, ecx->ni_ks, (int)ecx->rn);
+    memset(ecx, 0, sizeof(ecx));
+    cx->ni = 1;
+}
+
+AESNI_TARGET static __m128i aesni_encrypt_block(__m128i b, const aes_08t *ks, int rn)
+{   int i;
+
+    b = _mm_xor_si128(b, _mm_loadu_si128((const __m128i *)ks));
+    for(i = 1; i < rn; ++i)
+        b = _mm_aesenc_si128(b, _mm_loadu_si128((const __m128i *)(ks + 16 * i)));
+    return _mm_aesenclast_si128(b, _mm_loadu_si128((const __m128i *)(ks + 16 * rn)));
+}
+
+AESNI_TARGET static __m128i aesni_decrypt_block(__m128i b, const aes_08t *ks, int rn)
+{   int i;
+
+    b = _mm_xor_si128(b, _mm_loadu_si128((const __m128i *)ks));
+    for(i = 1; i < rn; ++i)
+        b = _mm_aesdec_si128(b, _mm_loadu_si128((const __m128i *)(ks + 16 * i)));
+    return _mm_aesdeclast_si128(b, _mm_loadu_si128((const __m128i *)(ks + 16 * rn)));
+}
+
+AESNI_TARGET void csql_aesni_encrypt(const unsigned char *in_blk, unsigned char *out_blk, const csql_aes_encrypt_ctx cx[1])
+{
+    _mm_storeu_si128((__m128i *)out_blk, aesni_encrypt_block(_mm_loadu_si128((const __m128i *)in_blk), cx->ni_ks, (int)cx->rn));
+}
+
+AESNI_TARGET void csql_aesni_decrypt(const unsigned char *in_blk, unsigned char *out_blk, const csql_aes_decrypt_ctx cx[1])
+{
+    _mm_storeu_si128((__m128i *)out_blk, aesni_decrypt_block(_mm_loadu_si128((const __m128i *)in_blk), cx->ni_ks, (int)cx->rn));
+}
+
+/* CBC encryption in place of nblocks in buf, chained from iv; each block depends on the previous one */
+
+AESNI_TARGET void csql_aesni_cbc_encrypt(unsigned char *buf, int nblocks, const unsigned char *iv, const csql_aes_encrypt_ctx cx[1])
+{   __m128i c = _mm_loadu_si128((const __m128i *)iv);
+    int i;
+
+    for(i = 0; i < nblocks; ++i, buf += 16)
+    {
+        c = aesni_encrypt_block(_mm_xor_si128(c, _mm_loadu_si128((const __m128i *)buf)), cx->ni_ks, (int)cx->rn);
+        _mm_storeu_si128((__m128i *)buf, c);
+    }
+}
+
+/* CBC decryption of the nblocks following the IV block at the start of buf, the plaintext is written
+   one block earlier (starting at buf) as decrypt_buffer expects; the blocks are independent, so
+   AESNI_PARALLEL of them are decrypted at a time */
+
+AESNI_TARGET void csql_aesni_cbc_decrypt(unsigned char *buf, int nblocks, const csql_aes_decrypt_ctx cx[1])
+{   const aes_08t *ks = cx->ni_ks;
+    int rn = (int)cx->rn, i, j;
+    __m128i b[AESNI_PARALLEL], c[AESNI_PARALLEL + 1], k;
+
+    for(; nblocks >= AESNI_PARALLEL; nblocks -= AESNI_PARALLEL, buf += 16 * AESNI_PARALLEL)
+    {
+        /* load all the ciphertext first, the plaintext overwrites it */
+        c[0] = _mm_loadu_si128((const __m128i *)buf);
+        k = _mm_loadu_si128((const __m128i *)ks);
+        for(j = 0; j < AESNI_PARALLEL; ++j)
+        {
+            c[j + 1] = _mm_loadu_si128((const __m128i *)(buf + 16 * (j + 1)));
+            b[j] = _mm_xor_si128(c[j + 1], k);
+        }
+
+        for(i = 1; i < rn; ++i)
+        {
+            k = _mm_loadu_si128((const __m128i *)(ks + 16 * i));
+            for(j = 0; j < AESNI_PARALLEL; ++j)
+                b[j] = _mm_aesdec_si128(b[j], k);
+        }
+
+        k = _mm_loadu_si128((const __m128i *)(ks + 16 * rn));
+        for(j = 0; j < AESNI_PARALLEL; ++j)
+            _mm_storeu_si128((__m128i *)(buf + 16 * j), _mm_xor_si128(_mm_aesdeclast_si128(b[j], k), c[j]));
+    }
+
+    for(; nblocks > 0; --nblocks, buf += 16)
+    {
+        c[0] = _mm_loadu_si128((const __m128i *)buf);
+        b[0] = aesni_decrypt_block(_mm_loadu_si128((const __m128i *)(buf + 16)), ks, rn);
+        _mm_storeu_si128((__m128i *)buf, _mm_xor_si128(b[0], c[0]));
+    }
+}
+
+#else
+
+int csql_aesni_supported(void)
+{
+    return 0;
+}
+
+void csql_aesni_encrypt_key(csql_aes_encrypt_ctx cx[1])
+{
+    cx->ni = 0;
+}
+
+void csql_aesni_decrypt_key(const unsigned char *in_key, int key_len, csql_aes_decrypt_ctx cx[1])
+{
+    cx->ni = 0;
+}
+
+/* never called, the ni flag of the contexts is never set */
+
+void csql_aesni_encrypt(const unsigned char *in_blk, unsigned char *out_blk, const csql_aes_encrypt_ctx cx[1]) {}
+void csql_aesni_decrypt(const unsigned char *in_blk, unsigned char *out_blk, const csql_aes_decrypt_ctx cx[1]) {}
+void csql_aesni_cbc_encrypt(unsigned char *buf, int nblocks, const unsigned char *iv, const csql_aes_encrypt_ctx cx[1]) {}
+void csql_aesni_cbc_decrypt(unsigned char *buf, int nblocks, const csql_aes_decrypt_ctx cx[1]) {}
+
+#endif
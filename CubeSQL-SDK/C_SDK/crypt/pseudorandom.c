@@ -16,6 +16,18 @@
 
 #include "pseudorandom.h"
 
+#ifdef WIN32
+#include <windows.h>
+static SRWLOCK rand_lock = SRWLOCK_INIT;
+#define RAND_LOCK()		AcquireSRWLockExclusive(&rand_lock)
+#define RAND_UNLOCK()	ReleaseSRWLockExclusive(&rand_lock)
+#else
+#include <pthread.h>
+static pthread_mutex_t rand_lock = PTHREAD_MUTEX_INITIALIZER;
+#define RAND_LOCK()		pthread_mutex_lock(&rand_lock)
+#define RAND_UNLOCK()	pthread_mutex_unlock(&rand_lock)
+#endif
+
 #define N 25
 #define M 7
 
@@ -25,9 +37,11 @@ void csql_rand_init (unsigned int seed)
 {
 	int k;
 
+	RAND_LOCK();
 	x[0] = (seed|1) & 0xffffffff;
 	for (k=1; k<N; k++)
 		x[k] = (69069 * x[k-1]) & 0xffffffff;
+	RAND_UNLOCK();
 }
 
 void csql_static_randinit (void)
@@ -42,6 +56,8 @@ unsigned int csql_rand_get (void)
 	static int k = 0;
 	int kk;
 
+	/* the generator state is shared by all connections, which may run on different threads */
+	RAND_LOCK();
 	if (k==N)
 	{
 		for (kk=0; kk < N-M; kk++)
@@ -54,6 +70,7 @@ unsigned int csql_rand_get (void)
 	}
 	
 	y = x[k++];
+	RAND_UNLOCK();
 	y ^= (y << 7) & 0x2b5b2500;
 	y ^= (y << 15) & 0xdb8b0000;
 	y &= 0xffffffff;     /* you may delete this line if word size = 32 */
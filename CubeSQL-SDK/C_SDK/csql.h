@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <limits.h>
 #include <fcntl.h>
 
 #ifdef WIN32
@@ -44,6 +45,8 @@
 #include <arpa/inet.h>
 #include <netinet/tcp.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <poll.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <errno.h>
@@ -90,7 +93,7 @@ extern "C"
 #define bsd_inet_pton       inet_pton
 #define bsd_shutdown        shutdown
 #define cleanup()           WSACleanup()
-#define bsd_select	        select
+#define bsd_poll(a,b,c)     WSAPoll((a),(b),(c))
 #define sock_read(a,b,c)	recv((a), (b), (c), 0L)
 #define sock_write(a,b,c)	send((a), (b), (c), 0L)
 #define	PATH_SEPARATOR	    "\\"
@@ -98,6 +101,7 @@ extern "C"
 #define mssleep(ms)         Sleep(ms)
 	
 typedef int socklen_t;
+struct iovec {void *iov_base; size_t iov_len;};
 typedef int ssize_t;
 typedef unsigned long in_addr_t;
 	
@@ -109,7 +113,7 @@ typedef unsigned long in_addr_t;
 #define bsd_getsockopt                  getsockopt
 #define bsd_inet_pton                   inet_pton
 #define bsd_shutdown                    shutdown
-#define bsd_select                      select
+#define bsd_poll                        poll
 #define	PATH_SEPARATOR                  "/"
 #define closesocket(s)                  close(s)
 #define cleanup()
@@ -175,6 +179,21 @@ typedef unsigned long in_addr_t;
 #define kMAXCHUNK						100*1024
 #define NO_TIMEOUT						0
 #define CONNECT_TIMEOUT					5
+#define kBATCH_WINDOW					16*1024		// bytes of pipelined requests in flight, well below the socket buffers
+#define kPREFETCH_MAX					(kBATCH_WINDOW/kHEADER_SIZE)	// cursor step requests in flight at most
+#define kRECV_BUFFER					32*1024		// bytes read ahead from the socket on each connection
+#define kCOALESCE_WRITE					16*1024		// pieces of a request gathered into one write, the size of a TLS record
+#define kSCRATCH_MIN					4*1024		// initial size of the scratch buffer
+#define kSCRATCH_CAP					4*1024*1024	// largest scratch buffer kept between requests
+#define kINFLATE_WINDOW					64*1024		// bytes of a compressed reply read and inflated at a time
+#define kCOMPRESS_MIN					512			// default size below which packets are not compressed
+#define kCOMPRESS_SAMPLE				4*1024		// bytes sampled to detect incompressible data
+#define kCOMPRESS_UNIFORM				512			// chi-square below which the sample looks random (256 expected)
+#define kCOMPRESS_POOR					90			// compressed size, in percent, above which a ratio is poor
+#define kCOMPRESS_POOR_RUN				4			// poor ratios in a row before backing off
+#define kCOMPRESS_BACKOFF				16			// packets sent uncompressed after backing off
+#define kRESULT_SAMPLE					64*1024		// smallest reply used to measure bandwidth and uncompress speed
+#define kRESULT_PROBE					32			// requests between two that advertise compression in auto mode
 	
 #if defined(HAVE_BZERO) || defined(bzero)
 // do nothing
@@ -325,6 +344,31 @@ struct csqldb {
 	char			        *inbuffer;
 	int				        insize;
 	
+	char			        *rbuffer;					// receive buffer, rbufstart..rbufend is received but not yet parsed
+	int				        rbufstart;
+	int				        rbufend;
+	
+	char			        *scratch;					// output of compression and encryption and inflate window, see csql_scratch
+	int				        scratchsize;
+	z_stream		        *deflater;					// deflate state reused by csql_compress
+	z_stream		        *inflater;					// inflate state reused by csql_netread_inflate
+	int				        zdeflatelevel;				// level deflater was set up with
+	int				        zlevel;						// compression policy, see cubesql_set_compression
+	int				        zminsize;
+	int				        zstatements;
+	int				        zpoor;						// poor ratios in a row
+	int				        zbackoff;					// packets left to send uncompressed
+	int64			        zbytesin;					// bytes compressed and the bytes sent for them
+	int64			        zbytesout;
+	int64			        zskipped;					// packets the policy did not compress
+	int				        rmode;						// result compression, see cubesql_set_result_compression
+	int				        rquery;						// mode overriding rmode, CUBESQL_COMPRESSION_DEFAULT for none
+	int				        rprobe;						// requests left before auto mode probes the compression ratio
+	int64			        rsent;						// time the first request since the last reply was sent, 0 for none
+	double			        rinflate;					// microseconds uncompress takes per expanded byte, 0 until measured
+	double			        rratio;						// compressed size of the replies over their expanded size
+	csqlresultstats	        rstats;
+	
 	inhead			        request;                    // request header
 	outhead			        reply;                      // response header
 	
@@ -332,13 +376,19 @@ struct csqldb {
 	struct tls              *tls_context;               // TLS context connection
 	#endif
 	
+	int				        vmcount;					// statements prepared on the connection
+	int				        vmcurrent;					// vmindex of the statement the server holds, 0 for none
+	int64			        vmreprepared;				// statements prepared again because another one was prepared since
+	
 	void (*trace) (const char*, void*);                 // trace callback
 	void                    *data;                      // user argument to be passed to the callbacks function
 };
 
 struct csqlvm {
 	csqldb		*db;
-	int			vmindex;
+	int			vmindex;					// identifies the statement on its connection
+	char		*sql;						// kept to prepare the statement again
+	int			nbound;						// highest parameter index bound by a separate cubesql_vmbind_* call
 };
 	
 struct csqlc {
@@ -373,6 +423,14 @@ struct csqlc {
 	int			*rowcount;
 	int			nbuffer;
 	int			nalloc;
+	
+	// server side cursors
+	int			prefetch;                               // step requests kept in flight
+	int			inflight;                               // step requests sent but not yet read
+	
+	// streamed chunk cursors
+	int			stream;                                 // chunks are acknowledged one at a time by the reader
+	int			stream_pending;                         // the server is waiting for kCHUNK_OK to send the next chunk
 };
 
 // private functions
@@ -384,15 +442,33 @@ void	csql_socketclose (csqldb *db);
 int		csql_connect (csqldb *db, int encryption);
 int		csql_connect_encrypted (csqldb *db);
 int		csql_netread (csqldb *db, int expected_size, int expected_nfields, int is_chunk, int *end_chunk, int timeout);
+int		csql_netread_inflate (csqldb *db, int timeout, int64 *work);
 csqlc  *csql_read_cursor (csqldb *db, csqlc *existing_c);
+csqlc  *csql_read_cursor_mode (csqldb *db, csqlc *existing_c, int stream);
 int		csql_checkinbuffer (csqldb *db);
 int		csql_netwrite (csqldb *db, char *size_array, int nsize_array, char *buffer, int nbuffer);
+int		csql_netwrite_buffer (csqldb *db, char *size_array, int nsize_array, char *buffer, int nbuffer, int is_scratch);
 int		csql_ack(csqldb *db, int chunk_code);
+int		csql_socketwait (csqldb *db);
 int		csql_socketwrite (csqldb *db, const char *buffer, int nbuffer);
+int		csql_socketwritev (csqldb *db, struct iovec *iov, int iovcnt);
 int		csql_socketread (csqldb *db, int is_header, int timeout);
+int		csql_socketreadn (csqldb *db, char *ptr, int nleft, int timeout);
+int		csql_socketrecv (csqldb *db, char *ptr, int nleft);
 int		csql_socketerror (int fd);
+int		csql_socketpoll (int fd, short events, int timeout, short *revents);
 int		csql_checkheader(csqldb *db, int expected_size, int expected_nfields, int *end_chunk);
 int		csql_sendchunk (csqldb *db, char *buffer, int bufferlen, int buffertype, int is_bind);
+int		csql_compress (csqldb *db, char *dest, uLong *destlen, const char *head, int headlen, const char *source, uLong sourcelen);
+int		csql_compress_check (csqldb *db, const char *buffer, int len);
+void	csql_compress_account (csqldb *db, int len, int newlen);
+int		csql_result_advertise (csqldb *db);
+void	csql_result_request (csqldb *db);
+void	csql_result_account (csqldb *db, int compressed, int len, int explen, int64 usec);
+void	csql_result_bandwidth (csqldb *db, int len, int64 usec);
+int64	csql_microtime (void);
+char	*csql_scratch (csqldb *db, int size);
+void	csql_scratch_release (csqldb *db);
 char	*csql_receivechunk (csqldb *db, int *len, int *is_end_chunk);
 void	csql_initrequest (csqldb *db, int packetsize, int nfields, char command, char selector);
 void	random_hash_field (unsigned char hval[], const char *randpoll, const char *field);
@@ -406,10 +482,24 @@ int		decrypt_buffer (char *buffer, int dim, csql_aes_decrypt_ctx ctx[1]);
 int		generate_session_key (csqldb *db, int encryption, char *password, char *rand1, char *rand2);
 int		csql_bindexecute(csqldb *db, const char *sql, char **colvalue, int *colsize, int *coltype, int ncols);
 int		csql_bind_value (csqldb *db, int index, int bindtype, char *value, int len);
+int		csql_format_int64 (char *buffer, int64 value);
+int		csql_bind_request (csqldb *db, int index, int bindtype, char *value, int len);
+int		csql_vmactivate (csqlvm *vm, int nparams);
+int		csql_vmbind_one (csqlvm *vm, int index, int bindtype, char *value, int len);
+int		csql_vmbind_pipeline (csqlvm *vm, int nparams, int *bindtype, char **value, int *len, char command, int *errcodes, int *failed, int *errcode, char *errmsg);
+int		csql_vmbind_send (csqldb *db, int nparams, int *bindtype, char **value, int *len, char command);
+int		csql_vmbind_drain (csqldb *db, int nparams, int *errcodes, int *failed, int *errcode, char *errmsg);
+int		csql_vmbind_abort (csqldb *db, int nparams, int from, int *errcodes, int *failed);
+int		csql_send_batch (csqldb *db, const char *sql, int is_select);
+int		csql_read_int64 (csqldb *db, int64 *value);
+int		csql_isneterror (int errcode);
 csqlc	*csql_cursor_alloc (csqldb *db);
 int		csql_cursor_reallocate (csqlc *c);
 int		csql_cursor_close (csqlc *c);
 int		csql_cursor_step (csqlc *c);
+int		csql_cursor_drain (csqlc *c);
+int64	csql_parse_int64 (const char *field, int len);
+double	csql_parse_double (const char *field, int len);
 void	csql_load_ssl (void);
 const	char *ssl_error(void);
 int		encryption_is_ssl (int encryption);
@@ -75,18 +75,20 @@ void cubesql_disconnect (csqldb *db, int gracefully) {
 	// clear errors first
 	cubesql_clear_errors(db);
 	
-	// sanity check on socket
-	if (db->sockfd <= 0) return;
-	
-	// disconnect
-	if (gracefully == kTRUE) {
-		csql_initrequest(db, 0, 0, kCOMMAND_CLOSE, kNO_SELECTOR);
-		csql_netwrite(db, NULL, 0, NULL, 0);
-		csql_netread(db, -1, -1, kFALSE, NULL, 1);
+	// socket is already closed after a failed connect or a cubesql_cancel
+	if (db->sockfd > 0) {
+		// disconnect
+		if (gracefully == kTRUE) {
+			csql_initrequest(db, 0, 0, kCOMMAND_CLOSE, kNO_SELECTOR);
+			csql_netwrite(db, NULL, 0, NULL, 0);
+			csql_netread(db, -1, -1, kFALSE, NULL, 1);
+		}
+		
+		// close socket
+		csql_socketclose(db);
 	}
 	
-	// close socket and free db
-	csql_socketclose(db);
+	// free db
 	csql_dbfree(db);
 }
 
@@ -104,9 +106,99 @@ int cubesql_execute (csqldb *db, const char *sql) {
 	return csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT);
 }
 
-csqlc *cubesql_select (csqldb *db, const char *sql, int is_serverside) {
-	// serverside is disabled in this version
+int cubesql_execute_ex (csqldb *db, const char *sql, int64 *changes, int64 *rowid) {
+	char	errmsg[512];
+	int		rc, errcode = CUBESQL_NOERR;
+	
+	*changes = 0;
+	*rowid = 0;
+	
+	// clear errors first
+	cubesql_clear_errors(db);
+	
+	// check for trace function
+	if (db->trace) db->trace(sql, db->data);
+	
+	// the statement and both queries go out back to back, the server replies to each of them in order
+	if (csql_send_statement (db, kCOMMAND_EXECUTE, sql, kFALSE, kFALSE) != CUBESQL_NOERR) return CUBESQL_ERR;
+	if (csql_send_statement (db, kCOMMAND_SELECT, "SHOW CHANGES;", kFALSE, kFALSE) != CUBESQL_NOERR) return CUBESQL_ERR;
+	if (csql_send_statement (db, kCOMMAND_SELECT, "SHOW LASTROWID;", kFALSE, kFALSE) != CUBESQL_NOERR) return CUBESQL_ERR;
+	
+	// read replay, a failed statement still leaves both replies to read
+	rc = csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT);
+	if (rc != CUBESQL_NOERR) {
+		if (csql_isneterror(db->errcode)) return CUBESQL_ERR;
+		errcode = db->errcode;
+		memcpy(errmsg, db->errmsg, sizeof(db->errmsg));
+	}
+	
+	if ((csql_read_int64(db, changes) != CUBESQL_NOERR) && (csql_isneterror(db->errcode))) return CUBESQL_ERR;
+	if ((csql_read_int64(db, rowid) != CUBESQL_NOERR) && (csql_isneterror(db->errcode))) return CUBESQL_ERR;
+	
+	if (rc != CUBESQL_NOERR) {
+		*changes = 0;
+		*rowid = 0;
+		csql_seterror(db, errcode, errmsg);
+		return CUBESQL_ERR;
+	}
+	
+	cubesql_clear_errors(db);
+	return CUBESQL_NOERR;
+}
+
+int cubesql_execute_batch (csqldb *db, int nstatements, const char **sql, int *is_select, csqlc **cursors, int *errcodes, char **errmsgs) {
+	int i, ok, nsent = 0, nread = 0, inflight = 0, first = -1;
+	
+	// every statement runs: a failed one gets its error code and a copy of the message (free it with free)
+	// and does not stop the statements after it, the first failure is also left as the connection error
+	for (i=0; i<nstatements; i++) {
+		cursors[i] = NULL;
+		errcodes[i] = CUBESQL_NOERR;
+		errmsgs[i] = NULL;
+	}
+	cubesql_clear_errors(db);
+	
+	while (nread < nstatements) {
+		// keep writing while the requests in flight fit the socket buffers, so neither side can block
+		// on a full buffer while the other one waits for it; a single statement is always sent
+		while ((nsent < nstatements) && ((nsent == nread) || (inflight + (int)strlen(sql[nsent]) + kHEADER_SIZE <= kBATCH_WINDOW))) {
+			if (csql_send_batch(db, sql[nsent], is_select[nsent]) != CUBESQL_NOERR) goto abort;
+			inflight += (int)strlen(sql[nsent]) + kHEADER_SIZE;
+			nsent++;
+		}
+		
+		// replies come in the order of the statements
+		cubesql_clear_errors(db);
+		if (is_select[nread]) {
+			cursors[nread] = csql_read_cursor(db, NULL);
+			ok = (cursors[nread] != NULL);
+		} else {
+			ok = (csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT) == CUBESQL_NOERR);
+		}
+		if (!ok) {
+			if (csql_isneterror(db->errcode)) goto abort;
+			errcodes[nread] = db->errcode;
+			errmsgs[nread] = strdup(db->errmsg);
+			if (first == -1) first = nread;
+		}
+		inflight -= (int)strlen(sql[nread]) + kHEADER_SIZE;
+		nread++;
+	}
+	
+	if (first == -1) {
+		cubesql_clear_errors(db);
+		return CUBESQL_NOERR;
+	}
+	csql_seterror(db, errcodes[first], (errmsgs[first]) ? errmsgs[first] : "");
+	return CUBESQL_ERR;
 	
+abort:
+	// the connection failed: the statement it failed on and all later ones share its error
+	for (i=nread; i<nstatements; i++) errcodes[i] = db->errcode;
+	return CUBESQL_ERR;
+}
+
+csqlc *cubesql_select (csqldb *db, const char *sql, int is_serverside) {
 	// clear errors first
 	cubesql_clear_errors(db);
 	
@@ -114,12 +206,29 @@ csqlc *cubesql_select (csqldb *db, const char *sql, int is_serverside) {
 	if (db->trace) db->trace(sql, db->data);
 	
 	// send sql statement
-	if (csql_send_statement (db, kCOMMAND_SELECT, sql, kFALSE, kFALSE) != CUBESQL_NOERR) return NULL;
+	if (csql_send_statement (db, kCOMMAND_SELECT, sql, kFALSE, (is_serverside) ? kTRUE : kFALSE) != CUBESQL_NOERR) return NULL;
 	
 	// read the cursor
 	return csql_read_cursor(db, NULL);
 }
 
+csqlc *cubesql_select_stream (csqldb *db, const char *sql) {
+	// like cubesql_select but returns as soon as the first chunk has been received,
+	// the next chunks are read one at a time with cubesql_cursor_stream_next
+	
+	// clear errors first
+	cubesql_clear_errors(db);
+	
+	// check for trace function
+	if (db->trace) db->trace(sql, db->data);
+	
+	// send sql statement
+	if (csql_send_statement (db, kCOMMAND_SELECT, sql, kFALSE, kFALSE) != CUBESQL_NOERR) return NULL;
+	
+	// read the first chunk
+	return csql_read_cursor_mode(db, NULL, kTRUE);
+}
+
 int cubesql_commit (csqldb *db) {
 	return cubesql_execute(db, "COMMIT;");
 }
@@ -164,6 +273,7 @@ void cubesql_cancel (csqldb *db) {
 		
 	bsd_shutdown(db->sockfd, SHUT_RDWR);
 	closesocket(db->sockfd);
+	db->rbufstart = db->rbufend = 0;
 	db->sockfd = 0;
 }
 
@@ -262,7 +372,7 @@ int cubesql_cursor_currentrow (csqlc *c) {
 int cubesql_cursor_seek (csqlc *c, int index) {
 	if (c->server_side == kTRUE) {
 		if (index != CUBESQL_SEEKNEXT) return kFALSE;
-		if (c->eof == kTRUE) return kFALSE;
+		if ((c->eof == kTRUE) || (c->db == NULL)) return kFALSE;
 		return (csql_cursor_step(c) == CUBESQL_NOERR) ? kTRUE : kFALSE;
 	}
 		
@@ -429,6 +539,102 @@ found_buffer:
 	return result;
 }
 
+void cubesql_cursor_setprefetch (csqlc *c, int nrows) {
+	// number of rows a server side cursor requests ahead of the current one, capped so that the
+	// requests in flight always fit the socket buffers while neither side reads (see kBATCH_WINDOW)
+	if (nrows > kPREFETCH_MAX) nrows = kPREFETCH_MAX;
+	if (c) c->prefetch = (nrows > 1) ? nrows : 1;
+}
+
+int cubesql_cursor_isserverside (csqlc *c) {
+	return (c) ? c->server_side : kFALSE;
+}
+
+int cubesql_cursor_isstream (csqlc *c) {
+	return (c) ? c->stream : kFALSE;
+}
+
+int cubesql_cursor_stream_pending (csqlc *c) {
+	return (c) ? c->stream_pending : kFALSE;
+}
+
+int cubesql_cursor_stream_next (csqlc *c) {
+	// acknowledge the chunks read so far and receive the next one (or the end of the stream):
+	// chunks already handed to the reader are released, except the first one that holds the column info
+	int last;
+	
+	if ((c == NULL) || (c->db == NULL)) return CUBESQL_ERR;
+	if (c->stream_pending == kFALSE) return CUBESQL_NOERR;
+	
+	last = c->nbuffer - 1;
+	if (last > 0) {
+		free(c->buffer[last]);
+		free(c->rowsum[last]);
+		c->buffer[last] = NULL;
+		c->rowsum[last] = NULL;
+	}
+	
+	c->stream_pending = kFALSE;
+	if (csql_ack(c->db, kCHUNK_OK) != CUBESQL_NOERR) return CUBESQL_ERR;
+	if (csql_read_cursor(c->db, c) == NULL) return CUBESQL_ERR;
+	return CUBESQL_NOERR;
+}
+
+int cubesql_cursor_stream_abort (csqlc *c) {
+	// tell the server to stop sending the remaining chunks
+	if ((c == NULL) || (c->db == NULL) || (c->stream_pending == kFALSE)) return CUBESQL_NOERR;
+	c->stream_pending = kFALSE;
+	return csql_ack(c->db, kCHUNK_ABORT);
+}
+
+void cubesql_cursor_detach (csqlc *c) {
+	// the connection has been closed: stop stepping and free the cursor later without talking to the server
+	if (c == NULL) return;
+	c->db = NULL;
+	c->eof = kTRUE;
+	c->inflight = 0;
+	c->stream_pending = kFALSE;
+}
+
+int cubesql_cursor_numchunks (csqlc *c) {
+	// custom and server side cursors do not keep their rows in contiguous chunks
+	if ((c->cursor_id == -1) || (c->server_side)) return 0;
+	if (c->nrows == 0) return 0;
+	return (c->nbuffer) ? c->nbuffer : 1;
+}
+
+int cubesql_cursor_chunk (csqlc *c, int index, char **data, int **size, int **sum, int *nfields) {
+	// returns the number of rows stored in chunk index (or -1) and its raw buffers:
+	// each row has nfields fields (the rowid column comes first when present),
+	// field n of the chunk starts at data + sum[n-1] and is size[n] bytes long (-1 means NULL)
+	int v1, v2, cnum;
+	
+	if ((index < 0) || (index >= cubesql_cursor_numchunks(c))) return -1;
+	
+	cnum = (c->has_rowid) ? c->ncols + 1 : c->ncols;
+	*nfields = cnum;
+	
+	if (c->nbuffer == 0) {
+		*data = c->data0;
+		*size = c->size0;
+		*sum = c->psum;
+		return c->nrows;
+	}
+	
+	v1 = (index == 0) ? 0 : c->rowcount[index-1];
+	v2 = c->rowcount[index];
+	
+	if (index == 0) {
+		*data = c->data0;
+		*size = c->size0;
+	} else {
+		*size = (int *) c->buffer[index];
+		*data = (char *) *size + ((v2 - v1) * cnum * sizeof(int));
+	}
+	*sum = c->rowsum[index];
+	return v2 - v1;
+}
+
 int64 cubesql_cursor_rowid (csqlc *c, int row) {
 	int	 len = 0;
 	char *rowid, buf[64] = {0};
@@ -512,8 +718,11 @@ void cubesql_cursor_free (csqlc *c) {
 	
 	if (c == NULL) return;
 	
-	// close the cursor on server side also
-	if (c->server_side) csql_cursor_close(c);
+	// close the cursor on server side also (unless its connection is already gone)
+	if ((c->server_side) && (c->db)) csql_cursor_close(c);
+	
+	// tell the server to stop sending the chunks of a stream that was not read to the end
+	cubesql_cursor_stream_abort(c);
 	
 	// check for special custom created cursor
 	if (c->cursor_id == -1) {
@@ -550,10 +759,183 @@ void cubesql_cursor_free (csqlc *c) {
 	free(c);
 }
 
+// MARK: - Columnar -
+
+// Fast text to number conversion used by the columnar accessors. Plain decimal values take the
+// fast path; anything else (hex, octal, blanks, overflow, locale specific text, ...) falls back
+// to strtoll/strtod so results match cubesql_cursor_int64 and cubesql_cursor_double.
+
+static const double csql_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int csql_is_little_endian (void) {
+	const unsigned int one = 1;
+	return (*(const unsigned char *)&one == 1);
+}
+
+static int csql_parse_eight_digits (const char *p, unsigned int *value) {
+	// SWAR: validate and convert 8 ASCII digits with a handful of 64 bit operations
+	unsigned long long v;
+	
+	memcpy(&v, p, sizeof(v));
+	if (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) != 0x3333333333333333ULL) return kFALSE;
+	
+	v = ((v & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+	v = ((v & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+	*value = (unsigned int)(((v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+	return kTRUE;
+}
+
+int64 csql_parse_int64 (const char *field, int len) {
+	const char			*p = field, *end = field + len;
+	unsigned long long	v = 0;
+	unsigned int		eight;
+	int					negative = kFALSE, ndigits;
+	char				buf[64];
+	
+	if ((p < end) && ((*p == '-') || (*p == '+'))) negative = (*p++ == '-');
+	ndigits = (int)(end - p);
+	
+	// at most 18 digits cannot overflow, a leading 0 means octal for strtoll
+	if ((ndigits > 0) && (ndigits <= 18) && ((*p != '0') || (ndigits == 1))) {
+		if (csql_is_little_endian()) {
+			while ((end - p >= 8) && (csql_parse_eight_digits(p, &eight))) {
+				v = (v * 100000000ULL) + eight;
+				p += 8;
+			}
+		}
+		while ((p < end) && (*p >= '0') && (*p <= '9')) {
+			v = (v * 10) + (*p - '0');
+			++p;
+		}
+		if (p == end) return (negative) ? -(int64)v : (int64)v;
+	}
+	
+	if (len > (int)sizeof(buf)-1) len = (int)sizeof(buf)-1;
+	memcpy(buf, field, len);
+	buf[len] = 0;
+	return strtoll(buf, NULL, 0);
+}
+
+double csql_parse_double (const char *field, int len) {
+	const char			*p = field, *end = field + len;
+	unsigned long long	m = 0;
+	int					negative = kFALSE, nsignificant = 0, ndigits = 0, exp10 = 0, e = 0, eneg = kFALSE, edigits = 0;
+	char				buf[64];
+	
+	if ((p < end) && ((*p == '-') || (*p == '+'))) negative = (*p++ == '-');
+	
+	while ((p < end) && (*p >= '0') && (*p <= '9')) {
+		if ((m) || (*p != '0')) ++nsignificant;
+		m = (m * 10) + (*p - '0');
+		++p; ++ndigits;
+		if (nsignificant > 19) goto slow_path;
+	}
+	if ((p < end) && (*p == '.')) {
+		++p;
+		while ((p < end) && (*p >= '0') && (*p <= '9')) {
+			if ((m) || (*p != '0')) ++nsignificant;
+			m = (m * 10) + (*p - '0');
+			++p; ++ndigits; --exp10;
+			if (nsignificant > 19) goto slow_path;
+		}
+	}
+	if (ndigits == 0) goto slow_path;
+	if ((p < end) && ((*p == 'e') || (*p == 'E'))) {
+		++p;
+		if ((p < end) && ((*p == '-') || (*p == '+'))) eneg = (*p++ == '-');
+		while ((p < end) && (*p >= '0') && (*p <= '9') && (edigits < 4)) {
+			e = (e * 10) + (*p - '0');
+			++p; ++edigits;
+		}
+		if (edigits == 0) goto slow_path;
+		exp10 += (eneg) ? -e : e;
+	}
+	if (p != end) goto slow_path;
+	
+	// both operands are exact, so a single multiplication or division is correctly rounded
+	if (m == 0) return (negative) ? -0.0 : 0.0;
+	if ((m <= (1ULL << 53)) && (exp10 >= -22) && (exp10 <= 22)) {
+		double d = (double)m;
+		d = (exp10 < 0) ? d / csql_pow10[-exp10] : d * csql_pow10[exp10];
+		return (negative) ? -d : d;
+	}
+	
+slow_path:
+	if (len > (int)sizeof(buf)-1) len = (int)sizeof(buf)-1;
+	memcpy(buf, field, len);
+	buf[len] = 0;
+	return strtod(buf, NULL);
+}
+
+// a kernel converts one column of nrows rows starting at field index first (stride fields per row)
+typedef void (*csql_column_kernel) (void *values, int row, const char *data, const int *size, const int *sum, int first, int stride, int nrows, unsigned char *nulls);
+
+#define CSQL_COLUMN_KERNEL(_name, _type, _parse)																\
+static void _name (void *values, int row, const char *data, const int *size, const int *sum,					\
+				   int first, int stride, int nrows, unsigned char *nulls) {									\
+	_type	*v = (_type *)values + row;																		\
+	int		i, n = first;																					\
+																											\
+	for (i=0; i<nrows; i++, n+=stride) {																	\
+		if (size[n] == -1) {																				\
+			nulls[(row+i) >> 3] |= (unsigned char)(1 << ((row+i) & 7));										\
+			v[i] = 0;																						\
+			continue;																						\
+		}																									\
+		v[i] = (_type)_parse((n > 0) ? data + sum[n-1] : data, size[n]);									\
+	}																										\
+}
+
+CSQL_COLUMN_KERNEL(csql_column_int64, int64, csql_parse_int64)
+CSQL_COLUMN_KERNEL(csql_column_int, int, csql_parse_int64)
+CSQL_COLUMN_KERNEL(csql_column_double, double, csql_parse_double)
+
+static int csql_cursor_column (csqlc *c, int column, csql_column_kernel kernel, void *values, unsigned char *nulls) {
+	char	*data;
+	int		*size, *sum;
+	int		i, nchunks, nrows, nfields, len, row = 0;
+	
+	if ((column <= 0) || (column > c->ncols) || (c->server_side)) return -1;
+	
+	nchunks = cubesql_cursor_numchunks(c);
+	if (nchunks == 0) {
+		// custom cursor, one field at a time
+		for (i=1; i<=c->nrows; i++) {
+			data = cubesql_cursor_field(c, i, column, &len);
+			if (data == NULL) len = -1;
+			kernel(values, i-1, data, &len, NULL, 0, 1, 1, nulls);
+		}
+		return c->nrows;
+	}
+	
+	for (i=0; i<nchunks; i++) {
+		nrows = cubesql_cursor_chunk(c, i, &data, &size, &sum, &nfields);
+		kernel(values, row, data, size, sum, (nfields - c->ncols) + (column-1), nfields, nrows, nulls);
+		row += nrows;
+	}
+	return row;
+}
+
+int cubesql_cursor_column_int64 (csqlc *c, int column, int64 *values, unsigned char *nulls) {
+	return csql_cursor_column(c, column, csql_column_int64, values, nulls);
+}
+
+int cubesql_cursor_column_int (csqlc *c, int column, int *values, unsigned char *nulls) {
+	return csql_cursor_column(c, column, csql_column_int, values, nulls);
+}
+
+int cubesql_cursor_column_double (csqlc *c, int column, double *values, unsigned char *nulls) {
+	return csql_cursor_column(c, column, csql_column_double, values, nulls);
+}
+
 // MARK: - VM -
 
 csqlvm *cubesql_vmprepare (csqldb *db, const char *sql) {
 	csqlvm	*vm = NULL;
+	int		len;
 	
 	// clear errors first
 	cubesql_clear_errors(db);
@@ -561,7 +943,8 @@ csqlvm *cubesql_vmprepare (csqldb *db, const char *sql) {
 	// check for trace function
 	if (db->trace) db->trace(sql, db->data);
 	
-	// send sql statement
+	// send sql statement, the server drops the statement prepared before
+	db->vmcurrent = 0;
 	if (csql_send_statement (db, kVM_PREPARE, sql, kFALSE, kFALSE) != CUBESQL_NOERR) return NULL;
 	
 	// read replay
@@ -571,49 +954,60 @@ csqlvm *cubesql_vmprepare (csqldb *db, const char *sql) {
 	vm = (csqlvm *) malloc (sizeof(csqlvm));
 	if (vm == NULL) return NULL;
 	
+	// keep the sql to prepare the statement again
+	len = (int)strlen(sql);
+	vm->sql = (char *) malloc(len+1);
+	if (vm->sql == NULL) {free(vm); return NULL;}
+	memcpy(vm->sql, sql, len+1);
+	
 	vm->db = db;
-	vm->vmindex = 0;
+	vm->vmindex = ++db->vmcount;
+	vm->nbound = 0;
+	db->vmcurrent = vm->vmindex;
 	return vm;
 }
 
 int cubesql_vmbind_int (csqlvm *vm, int index, int intvalue) {
-	char	value[256];
+	char	value[32];
 	
 	// convert int to text
-	snprintf(value, sizeof(value), "%d", intvalue);
-	return csql_bind_value(vm->db, index, CUBESQL_BIND_INTEGER, value, -1);
+	return csql_vmbind_one(vm, index, CUBESQL_BIND_INTEGER, value, csql_format_int64(value, intvalue));
 }
 
 int cubesql_vmbind_double (csqlvm *vm, int index, double dvalue) {
-	char	value[256];
+	char	value[32];
 	
-	// convert double to text
-	snprintf(value, sizeof(value), "%f", dvalue);
-	return csql_bind_value(vm->db, index, CUBESQL_BIND_DOUBLE, value, -1);
+	// convert double to text, with enough digits to read back the same value
+	return csql_vmbind_one(vm, index, CUBESQL_BIND_DOUBLE, value, snprintf(value, sizeof(value), "%.17g", dvalue));
 }
 
 int cubesql_vmbind_text (csqlvm *vm, int index, char *value, int len) {
-	return csql_bind_value(vm->db, index, CUBESQL_BIND_TEXT, value, -1);
+	// len can be -1 for a 0-terminated value
+	return csql_vmbind_one(vm, index, CUBESQL_BIND_TEXT, value, len);
 }
 
 int cubesql_vmbind_blob (csqlvm *vm, int index, void *value, int len) {
-	return csql_bind_value(vm->db, index, CUBESQL_BIND_BLOB, (char *)value, len);
+	return csql_vmbind_one(vm, index, CUBESQL_BIND_BLOB, (char *)value, len);
 }
 
 int cubesql_vmbind_null (csqlvm *vm, int index) {
-	return csql_bind_value(vm->db, index, CUBESQL_BIND_NULL, NULL, 0);
+	return csql_vmbind_one(vm, index, CUBESQL_BIND_NULL, NULL, 0);
 }
 
 int cubesql_vmbind_int64 (csqlvm *vm, int index, int64 int64value) {
-	char	value[256];
+	char	value[32];
 	
 	// convert int to text
-	snprintf(value, sizeof(value), "%lld", int64value);
-	return csql_bind_value(vm->db, index, CUBESQL_BIND_INT64, value, -1);
+	return csql_vmbind_one(vm, index, CUBESQL_BIND_INT64, value, csql_format_int64(value, int64value));
 }
 
 int cubesql_vmbind_zeroblob (csqlvm *vm, int index, int len) {
-	return csql_bind_value(vm->db, index, CUBESQL_BIND_ZEROBLOB, NULL, len);
+	return csql_vmbind_one(vm, index, CUBESQL_BIND_ZEROBLOB, NULL, len);
+}
+
+int cubesql_vmbind_value (csqlvm *vm, int index, int bindtype, char *value, int len) {
+	// value is sent as is, already converted to text for the numeric types
+	return csql_vmbind_one(vm, index, bindtype, value, len);
 }
 
 int cubesql_vmexecute (csqlvm *vm) {
@@ -621,8 +1015,10 @@ int cubesql_vmexecute (csqlvm *vm) {
 	
 	// clear errors first
 	cubesql_clear_errors(db);
+	if (csql_vmactivate(vm, 0) != CUBESQL_NOERR) return CUBESQL_ERR;
 	
 	// send VMEXECUTE command
+	csql_result_request(db);
 	csql_initrequest(db, 0, 0, kVM_EXECUTE, kNO_SELECTOR);
 	csql_netwrite(db, NULL, 0, NULL, 0);
 	
@@ -635,8 +1031,10 @@ csqlc *cubesql_vmselect (csqlvm *vm) {
 	
 	// clear errors first
 	cubesql_clear_errors(db);
+	if (csql_vmactivate(vm, 0) != CUBESQL_NOERR) return NULL;
 	
 	// send VMSELECT command
+	csql_result_request(db);
 	csql_initrequest(db, 0, 0, kVM_SELECT, kNO_SELECTOR);
 	csql_netwrite(db, NULL, 0, NULL, 0);
 	
@@ -649,12 +1047,120 @@ int cubesql_vmclose (csqlvm *vm) {
 	
 	csqldb *db = vm->db;
 	
-	csql_initrequest(db, 0, 0, kVM_CLOSE, kNO_SELECTOR);
-	csql_netwrite(db, NULL, 0, NULL, 0);
-	csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT);
+	// a statement the server no longer holds has nothing to close there
+	if (db->vmcurrent == vm->vmindex) {
+		csql_initrequest(db, 0, 0, kVM_CLOSE, kNO_SELECTOR);
+		csql_netwrite(db, NULL, 0, NULL, 0);
+		csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT);
+		db->vmcurrent = 0;
+	}
 	
+	cubesql_vmfree(vm);
+	return CUBESQL_NOERR;
+}
+
+void cubesql_vmfree (csqlvm *vm) {
+	// release the VM without notifying the server (connection closed or in use)
+	if (!vm) return;
+	if (vm->sql) free(vm->sql);
 	free(vm);
+}
+
+int cubesql_vmbind_execute (csqlvm *vm, int nparams, int *bindtype, char **value, int *len, int *errcodes, int *failed) {
+	csqldb	*db = vm->db;
+	char	errmsg[512];
+	int		errcode, rc;
+	
+	// binds and execute go out back to back, the server replies to each of them in order
+	*failed = -1;
+	if (csql_vmactivate(vm, nparams) != CUBESQL_NOERR) return CUBESQL_ERR;
+	if (csql_vmbind_pipeline(vm, nparams, bindtype, value, len, kVM_EXECUTE, errcodes, failed, &errcode, errmsg) != CUBESQL_NOERR) return CUBESQL_ERR;
+	rc = csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT);
+	if (*failed == -1) {
+		if (rc != CUBESQL_NOERR) *failed = nparams;
+		return rc;
+	}
+	
+	// a failed bind is reported instead of the outcome of the statement
+	csql_seterror(db, errcode, errmsg);
+	return CUBESQL_ERR;
+}
+
+int cubesql_vmexecute_many (csqlvm *vm, int nrows, int nparams, int *bindtype, char **value, int *len, int64 *changes, int *failed_row, int *failed_param) {
+	csqldb	*db = vm->db;
+	char	errmsg[512];
+	int		*errcodes = NULL;
+	int		row, base, rc, failed = -1, errcode = CUBESQL_NOERR;
+	
+	*failed_row = -1;
+	*failed_param = -1;
+	if (csql_vmactivate(vm, nparams) != CUBESQL_NOERR) return CUBESQL_ERR;
+	if (nparams > 0) {
+		errcodes = (int *) malloc(sizeof(int) * nparams);
+		if (errcodes == NULL) {
+			csql_seterror(db, CUBESQL_MEMORY_ERROR, "Unable to allocate bind results");
+			return CUBESQL_ERR;
+		}
+	}
+	
+	// one round trip per row: the binds, the execute and the changes() query go out together,
+	// then the replies are read in order; the first failed row stops the loop
+	for (row=0; row<nrows; row++) {
+		base = row * nparams;
+		cubesql_clear_errors(db);
+		failed = -1;
+		
+		if (csql_vmbind_send(db, nparams, bindtype+base, value+base, len+base, kVM_EXECUTE) <= nparams) goto abort;
+		if ((changes) && (csql_send_statement(db, kCOMMAND_SELECT, "SELECT changes();", kFALSE, kFALSE) != CUBESQL_NOERR)) goto abort;
+		if (csql_vmbind_drain(db, nparams, errcodes, &failed, &errcode, errmsg) != CUBESQL_NOERR) goto abort;
+		
+		rc = csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT);
+		if ((rc != CUBESQL_NOERR) && (csql_isneterror(db->errcode))) goto abort;
+		if ((rc != CUBESQL_NOERR) && (failed == -1)) {
+			failed = nparams;
+			errcode = db->errcode;
+			memcpy(errmsg, db->errmsg, sizeof(db->errmsg));
+		}
+		
+		if (changes) {
+			changes[row] = 0;
+			if ((csql_read_int64(db, &changes[row]) != CUBESQL_NOERR) && (csql_isneterror(db->errcode))) goto abort;
+		}
+		
+		if (failed != -1) {
+			csql_seterror(db, errcode, errmsg);
+			goto abort;
+		}
+	}
+	
+	if (errcodes) free(errcodes);
 	return CUBESQL_NOERR;
+	
+abort:
+	*failed_row = row;
+	*failed_param = failed;
+	if (errcodes) free(errcodes);
+	return CUBESQL_ERR;
+}
+
+csqlc *cubesql_vmbind_select (csqlvm *vm, int nparams, int *bindtype, char **value, int *len, int *errcodes, int *failed) {
+	csqldb	*db = vm->db;
+	csqlc	*c;
+	char	errmsg[512];
+	int		errcode;
+	
+	*failed = -1;
+	if (csql_vmactivate(vm, nparams) != CUBESQL_NOERR) return NULL;
+	if (csql_vmbind_pipeline(vm, nparams, bindtype, value, len, kVM_SELECT, errcodes, failed, &errcode, errmsg) != CUBESQL_NOERR) return NULL;
+	c = csql_read_cursor(db, NULL);
+	if (*failed == -1) {
+		if (c == NULL) *failed = nparams;
+		return c;
+	}
+	
+	if (c) cubesql_cursor_free(c);
+	csql_seterror(db, errcode, errmsg);
+	return NULL;
 }
 
 // MARK: - Private -
@@ -670,6 +1176,10 @@ csqldb *cubesql_cursor_db (csqlc *cursor) {
 	return cursor->db;
 }
 
+csqldb *cubesql_vm_db (csqlvm *vm) {
+	return vm->db;
+}
+
 void cubesql_setuserptr (csqldb *db, void *userptr) {
 	db->userptr = userptr;
 }
@@ -692,6 +1202,44 @@ char *cubesql_gettoken (csqldb *db) {
 	return db->token;
 }
 
+void cubesql_set_compression (csqldb *db, int level, int min_size, int statements) {
+	// level is a zlib level (-1 for the default, 0 disables compression), packets below min_size
+	// are sent as they are and statements enables the compression of large statement bodies
+	db->zlevel = (level < -1) ? -1 : (level > 9) ? 9 : level;
+	db->zminsize = (min_size < 0) ? 0 : min_size;
+	db->zstatements = (statements) ? kTRUE : kFALSE;
+	db->zpoor = 0;
+	db->zbackoff = 0;
+}
+
+void cubesql_compression_stats (csqldb *db, int64 *bytes_in, int64 *bytes_out, int64 *skipped) {
+	if (bytes_in) *bytes_in = db->zbytesin;
+	if (bytes_out) *bytes_out = db->zbytesout;
+	if (skipped) *skipped = db->zskipped;
+}
+
+void cubesql_set_result_compression (csqldb *db, int mode) {
+	// whether requests tell the server it may compress its replies, CUBESQL_COMPRESSION_AUTO decides
+	// from the measured bandwidth, compression ratio and uncompress speed of the connection
+	if ((mode < CUBESQL_COMPRESSION_OFF) || (mode > CUBESQL_COMPRESSION_AUTO)) mode = CUBESQL_COMPRESSION_ON;
+	db->rmode = mode;
+	db->rprobe = kRESULT_PROBE;
+}
+
+void cubesql_set_query_compression (csqldb *db, int mode) {
+	// overrides the mode of the connection until it is set back to CUBESQL_COMPRESSION_DEFAULT
+	if ((mode < CUBESQL_COMPRESSION_DEFAULT) || (mode > CUBESQL_COMPRESSION_AUTO)) mode = CUBESQL_COMPRESSION_DEFAULT;
+	db->rquery = mode;
+}
+
+void cubesql_result_stats (csqldb *db, csqlresultstats *stats) {
+	*stats = db->rstats;
+}
+
+int64 cubesql_vm_reprepared (csqldb *db) {
+	return db->vmreprepared;
+}
+
 csqlc *cubesql_cursor_create (csqldb *db, int nrows, int ncolumns, int *types, char **names) {
 	csqlc *cursor = NULL;
 	char  *p = NULL, *s = NULL;
@@ -799,32 +1347,50 @@ void cubesql_seterror(csqldb *db, int errcode, const char *errmsg) {
 	csql_seterror(db, errcode, errmsg);
 }
 
+int cubesql_isneterror (int errcode) {
+	return csql_isneterror(errcode);
+}
+
 // MARK: - Reserved -
 
-void csql_libinit (void) {
+static void csql_libinit_once (void) {
 	#ifdef WIN32
 	WSADATA wsaData;
 	#else
 	struct sigaction act;
 	#endif
-	static int lib_inited = kFALSE;
 	
-	if (lib_inited == kFALSE) {
-		lib_inited = kTRUE;
-		csql_static_randinit();
-		csql_gen_tabs();
-		
-		#ifdef WIN32
-		WSAStartup(MAKEWORD(2,2), &wsaData);
-		#else
-		// IGNORE SIGPIPE and SIGABORT
-		act.sa_handler = SIG_IGN;
-		sigemptyset(&act.sa_mask);
-		act.sa_flags = 0;
-		sigaction(SIGPIPE, &act, (struct sigaction *)NULL);
-		sigaction(SIGABRT, &act, (struct sigaction *)NULL);
-		#endif
-	}
+	csql_static_randinit();
+	csql_gen_tabs();
+	
+	#ifdef WIN32
+	WSAStartup(MAKEWORD(2,2), &wsaData);
+	#else
+	// IGNORE SIGPIPE and SIGABORT
+	act.sa_handler = SIG_IGN;
+	sigemptyset(&act.sa_mask);
+	act.sa_flags = 0;
+	sigaction(SIGPIPE, &act, (struct sigaction *)NULL);
+	sigaction(SIGABRT, &act, (struct sigaction *)NULL);
+	#endif
+}
+
+#ifdef WIN32
+static BOOL CALLBACK csql_libinit_win32 (PINIT_ONCE once, PVOID param, PVOID *context) {
+	csql_libinit_once();
+	return TRUE;
+}
+#endif
+
+void csql_libinit (void) {
+	// connections can be opened concurrently from different threads
+	#ifdef WIN32
+	static INIT_ONCE lib_inited = INIT_ONCE_STATIC_INIT;
+	InitOnceExecuteOnce(&lib_inited, csql_libinit_win32, NULL, NULL);
+	#else
+	static pthread_once_t lib_inited = PTHREAD_ONCE_INIT;
+	pthread_once(&lib_inited, csql_libinit_once);
+	#endif
 }
 
 csqldb *csql_dbinit (const char *host, int port, const char *username, const char *password, int timeout, int encryption, const char *ssl_certificate, const char *root_certificate, const char *ssl_certificate_password, const char *ssl_chiper_list) {
@@ -843,6 +1409,12 @@ csqldb *csql_dbinit (const char *host, int port, const char *username, const cha
 	db->token = NULL;
 	db->useOldProtocol = kFALSE;
 	db->verifyPeer = kFALSE;
+	db->zlevel = Z_DEFAULT_COMPRESSION;
+	db->zminsize = kCOMPRESS_MIN;
+	db->rmode = CUBESQL_COMPRESSION_ON;
+	db->rquery = CUBESQL_COMPRESSION_DEFAULT;
+	db->rprobe = kRESULT_PROBE;
+	db->rstats.advertising = kTRUE;
 	
 	snprintf((char *) db->host, sizeof(db->host), "%s", host);
 	snprintf((char *) db->username, sizeof(db->username),  "%s", username);
@@ -931,6 +1503,10 @@ load_ssl_abort:
 
 void csql_dbfree (csqldb *db) {
 	if (db->inbuffer) free(db->inbuffer);
+	if (db->rbuffer) free(db->rbuffer);
+	if (db->scratch) free(db->scratch);
+	if (db->deflater) {deflateEnd(db->deflater); free(db->deflater);}
+	if (db->inflater) {inflateEnd(db->inflater); free(db->inflater);}
 	free(db);
 }
 
@@ -947,6 +1523,7 @@ void csql_socketclose (csqldb *db) {
 	
 	bsd_shutdown(db->sockfd, SHUT_RDWR);
 	closesocket(db->sockfd);
+	db->rbufstart = db->rbufend = 0;
 }
 
 int csql_socketconnect (csqldb *db) {
@@ -1062,83 +1639,62 @@ int csql_socketconnect (csqldb *db) {
 	rc = 0;
 	
 	int sockfd = 0;
-	fd_set write_fds;
-	fd_set except_fds;
-	struct timeval tv;
+	struct pollfd poll_fds[MAX_SOCK_LIST];
 
 	while ((now - start) < connect_timeout) {
-		FD_ZERO(&write_fds);
-		FD_ZERO(&except_fds);
-		
-		tv.tv_sec = connect_timeout;
-		tv.tv_usec = 0;
-
+		// wait for all the sockets still trying to connect at once
+		int npoll = 0;
 		for (int i=0; i<MAX_SOCK_LIST; ++i) {
 			if (sock_list[i] > 0) {
-				FD_SET(sock_list[i], &write_fds);
-				FD_SET(sock_list[i], &except_fds);
-
-				rc = bsd_select(sock_list[i] + 1, NULL, &write_fds, &except_fds, &tv);
-				
-				if (rc == 0) {
-					// timeout - we can't use this socket
-					closesocket(sock_list[i]);
-					sock_list[i] = -1;
-					continue;
-				}
-
-				if (rc < 0) {
-					if (errno == 0 || errno == EINTR || errno == EAGAIN || errno == EINPROGRESS) {
-						// socket is still connecting
-						continue;
-					}
-					
-					// socket bsd_select error - don't use this socket
-					/*
-					printf("socket bsd_select error: %s (%i)\n", strerror(errno), errno);
-					*/
-					lastConnectionErrorMessage = strerror(errno);
-					closesocket(sock_list[i]);
-					sock_list[i] = -1;
-					continue;
-				}
+				poll_fds[npoll].fd = sock_list[i];
+				poll_fds[npoll].events = POLLOUT;
+				poll_fds[npoll].revents = 0;
+				++npoll;
 			}
 		}
+		if (npoll == 0) break;
 		
-		// check for error
-		for (int i=0; i<MAX_SOCK_LIST; ++i) {
-			if (sock_list[i] > 0) {
-				if (FD_ISSET(sock_list[i], &except_fds)) {
-					int err = csql_socketerror(sock_list[i]);
-					if (err > 0) {
-						lastConnectionErrorMessage = strerror(err);
-					}
-
-					closesocket(sock_list[i]);
-					sock_list[i] = -1;
-				}
+		rc = bsd_poll(poll_fds, npoll, (int)(connect_timeout - (now - start)) * 1000);
+		
+		if (rc == 0) {
+			// timeout - we can't use these sockets, they are closed below
+			break;
+		}
+		
+		if (rc < 0) {
+			if (errno == 0 || errno == EINTR || errno == EAGAIN || errno == EINPROGRESS) {
+				// sockets are still connecting
+				now = time(NULL);
+				continue;
 			}
+			
+			// socket bsd_poll error - don't use these sockets
+			lastConnectionErrorMessage = strerror(errno);
+			break;
 		}
 		
 		// check which file descriptor is ready for writing (need to check for socket error also)
-		for (int i=0; i<MAX_SOCK_LIST; ++i) {
-			if (sock_list[i] > 0) {
-				if (FD_ISSET(sock_list[i], &write_fds)) {
-					int err = csql_socketerror(sock_list[i]);
-					if (err > 0) {
-						lastConnectionErrorMessage = strerror(err);
-
-						closesocket(sock_list[i]);
-						sock_list[i] = -1;
-					} else {
-						//use this socket - break loop (use first one, don't overwrite sockfd with next possible one)
-						sockfd = sock_list[i];
-						break;
-					}
-				}
+		for (int i=0; i<npoll; ++i) {
+			short revents = poll_fds[i].revents;
+			if (revents == 0) continue;
+			
+			int err = csql_socketerror(poll_fds[i].fd);
+			if ((err == 0) && (revents & (POLLERR | POLLHUP | POLLNVAL))) err = -1;
+			if ((err == 0) && (revents & POLLOUT) && (sockfd == 0)) {
+				//use this socket - don't overwrite sockfd with next possible one
+				sockfd = poll_fds[i].fd;
+				continue;
 			}
+			
+			if (err == 0) continue;
+			if (err > 0) lastConnectionErrorMessage = strerror(err);
+			
+			for (int j=0; j<MAX_SOCK_LIST; ++j) {
+				if (sock_list[j] == poll_fds[i].fd) sock_list[j] = -1;
+			}
+			closesocket(poll_fds[i].fd);
 		}
-
+		
 		// check if a valid descriptor has been found
 		if (sockfd != 0) break;
 
@@ -1206,7 +1762,32 @@ int csql_socketconnect (csqldb *db) {
 	return sockfd;
 }
 
+int csql_format_int64 (char *buffer, int64 value) {
+	char	digits[24];
+	int		n = 0, len = 0;
+	unsigned long long	u = (value < 0) ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+	
+	// digits come out in reverse order, buffer needs room for 21 bytes
+	do {
+		digits[n++] = (char)('0' + (u % 10));
+		u /= 10;
+	} while (u);
+	
+	if (value < 0) buffer[len++] = '-';
+	while (n) buffer[len++] = digits[--n];
+	buffer[len] = 0;
+	return len;
+}
+
 int csql_bind_value (csqldb *db, int index, int bindtype, char *value, int len) {
+	// send request
+	if (csql_bind_request(db, index, bindtype, value, len) != CUBESQL_NOERR) return CUBESQL_ERR;
+	
+	// read reply
+	return csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT);
+}
+
+int csql_bind_request (csqldb *db, int index, int bindtype, char *value, int len) {
 	int field_size[1];
 	int nfields = 0, nsizedim = 0, packet_size = 0, datasize = 0;
 	
@@ -1226,17 +1807,134 @@ int csql_bind_value (csqldb *db, int index, int bindtype, char *value, int len)
 		}
 	}
 	
-	// prepare BIND command
-	csql_initrequest(db, packet_size, nfields, kVM_BIND, kNO_SELECTOR);
-	db->request.flag3 = (unsigned char) bindtype;
-	db->request.reserved1 = htons(index);
-	if (bindtype == CUBESQL_BIND_ZEROBLOB) db->request.expandedSize = htonl(len);
-	
-	// send request
-	csql_netwrite(db, (char *) field_size, nsizedim, (char *)value, datasize);
-	
-	// read reply
-	return csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT);
+	// prepare BIND command
+	csql_initrequest(db, packet_size, nfields, kVM_BIND, kNO_SELECTOR);
+	db->request.flag3 = (unsigned char) bindtype;
+	db->request.reserved1 = htons(index);
+	if (bindtype == CUBESQL_BIND_ZEROBLOB) db->request.expandedSize = htonl(len);
+	
+	// send request
+	return csql_netwrite(db, (char *) field_size, nsizedim, (char *)value, datasize);
+}
+
+int csql_send_batch (csqldb *db, const char *sql, int is_select) {
+	// check for trace function
+	if (db->trace) db->trace(sql, db->data);
+	
+	return csql_send_statement(db, (is_select) ? kCOMMAND_SELECT : kCOMMAND_EXECUTE, sql, kFALSE, kFALSE);
+}
+
+int csql_read_int64 (csqldb *db, int64 *value) {
+	csqlc *c;
+	
+	// reads the one value cursor sent for a pipelined query
+	cubesql_clear_errors(db);
+	c = csql_read_cursor(db, NULL);
+	if (c == NULL) return CUBESQL_ERR;
+	
+	*value = cubesql_cursor_int64(c, 1, 1, 0);
+	cubesql_cursor_free(c);
+	return CUBESQL_NOERR;
+}
+
+int csql_isneterror (int errcode) {
+	// client side failures and the socket/protocol codes, everything else comes from the server
+	return ((errcode < 0) || ((errcode >= ERR_SOCKET_INVALID_PORT_HOST) && (errcode <= ERR_SSL)));
+}
+
+int csql_vmactivate (csqlvm *vm, int nparams) {
+	csqldb *db = vm->db;
+	
+	// requests carry no statement, the server runs the one prepared last on the connection:
+	// prepare this one again if another statement was prepared since (or the session is new)
+	if (db->vmcurrent == vm->vmindex) return CUBESQL_NOERR;
+	
+	// preparing again drops the values bound on the server, which is only harmless when the caller
+	// binds parameters 1..nparams itself and nothing above was bound by a separate call
+	if (vm->nbound > nparams) {
+		vm->nbound = 0;
+		csql_seterror(db, CUBESQL_PARAMETER_ERROR, "Bound parameters were dropped because another statement was prepared on the connection, bind them again");
+		return CUBESQL_ERR;
+	}
+	
+	cubesql_clear_errors(db);
+	db->vmcurrent = 0;
+	if (csql_send_statement(db, kVM_PREPARE, vm->sql, kFALSE, kFALSE) != CUBESQL_NOERR) return CUBESQL_ERR;
+	if (csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT) != CUBESQL_NOERR) return CUBESQL_ERR;
+	
+	db->vmcurrent = vm->vmindex;
+	db->vmreprepared++;
+	vm->nbound = 0;
+	return CUBESQL_NOERR;
+}
+
+int csql_vmbind_one (csqlvm *vm, int index, int bindtype, char *value, int len) {
+	// a value bound by a separate call stays on the server until the statement is prepared again
+	if (csql_vmactivate(vm, 0) != CUBESQL_NOERR) return CUBESQL_ERR;
+	if (csql_bind_value(vm->db, index, bindtype, value, len) != CUBESQL_NOERR) return CUBESQL_ERR;
+	if (index > vm->nbound) vm->nbound = index;
+	return CUBESQL_NOERR;
+}
+
+int csql_vmbind_pipeline (csqlvm *vm, int nparams, int *bindtype, char **value, int *len, char command, int *errcodes, int *failed, int *errcode, char *errmsg) {
+	csqldb	*db = vm->db;
+	int		nsent;
+	
+	// clear errors first
+	cubesql_clear_errors(db);
+	*failed = -1;
+	
+	nsent = csql_vmbind_send(db, nparams, bindtype, value, len, command);
+	if (nsent <= nparams) return csql_vmbind_abort(db, nparams, nsent, errcodes, failed);
+	
+	// the server runs the command even when a bind failed, so its reply still has to be read by the caller
+	return csql_vmbind_drain(db, nparams, errcodes, failed, errcode, errmsg);
+}
+
+int csql_vmbind_send (csqldb *db, int nparams, int *bindtype, char **value, int *len, char command) {
+	int nsent;
+	
+	// write every kVM_BIND request and the command without waiting for the replies in between
+	// (parameter i is bound to index i+1), returns the number of requests written
+	csql_result_request(db);
+	for (nsent=0; nsent<nparams; nsent++) {
+		if (csql_bind_request(db, nsent+1, bindtype[nsent], value[nsent], len[nsent]) != CUBESQL_NOERR) return nsent;
+	}
+	csql_initrequest(db, 0, 0, command, kNO_SELECTOR);
+	if (csql_netwrite(db, NULL, 0, NULL, 0) != CUBESQL_NOERR) return nsent;
+	
+	return nsent + 1;
+}
+
+int csql_vmbind_drain (csqldb *db, int nparams, int *errcodes, int *failed, int *errcode, char *errmsg) {
+	int i;
+	
+	// read the bind replies in order, keeping the first failure
+	for (i=0; i<nparams; i++) {
+		if (csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT) == CUBESQL_NOERR) {
+			errcodes[i] = CUBESQL_NOERR;
+			continue;
+		}
+		if (csql_isneterror(db->errcode)) return csql_vmbind_abort(db, nparams, i, errcodes, failed);
+		errcodes[i] = db->errcode;
+		if (*failed == -1) {
+			*failed = i;
+			*errcode = db->errcode;
+			memcpy(errmsg, db->errmsg, sizeof(db->errmsg));
+		}
+		cubesql_clear_errors(db);
+	}
+	return CUBESQL_NOERR;
+}
+
+int csql_vmbind_abort (csqldb *db, int nparams, int from, int *errcodes, int *failed) {
+	int i;
+	
+	// the connection failed: the parameter it failed on and all later ones share its error
+	if (from > nparams) from = nparams;
+	if ((*failed == -1) || (*failed > from)) *failed = from;
+	for (i=from; i<nparams; i++) errcodes[i] = db->errcode;
+	return CUBESQL_ERR;
 }
 
 int csql_bindexecute(csqldb *db, const char *sql, char **colvalue, int *colsize, int *coltype, int nvalues) {
@@ -1281,14 +1979,27 @@ int csql_send_statement (csqldb *db, int command_type, const char *sql, int is_p
 	int field_size[1];
 	int nfields, nsizedim, packet_size, datasize = 0;
 	
+	char *dest = NULL;
+	uLong newlen = 0;
+	
 	nfields = 1;
 	nsizedim = sizeof(int) * nfields;
 	datasize = (int)strlen(sql) + 1;
+	field_size[0] = htonl(datasize);
+	
+	// large statement bodies are compressed together with their size array when enabled
+	if ((db->zstatements) && (csql_compress_check(db, sql, datasize))) {
+		newlen = compressBound(nsizedim + datasize);
+		dest = csql_scratch(db, (int)newlen+1);
+		if ((dest) && (csql_compress(db, dest, &newlen, (const char *) field_size, nsizedim, sql, (uLong)datasize) != Z_OK)) dest = NULL;
+		if (dest) csql_compress_account(db, nsizedim + datasize, (int)newlen);
+		if ((dest) && (newlen >= (uLong)(nsizedim + datasize))) dest = NULL;
+	}
 	
 	// build packet
-	packet_size = datasize + nsizedim;
+	packet_size = (dest) ? (int)newlen : datasize + nsizedim;
+	csql_result_request(db);
 	csql_initrequest(db, packet_size, nfields, command_type, kNO_SELECTOR);
-	field_size[0] = htonl(datasize);
 	
 	if (command_type == kCOMMAND_SELECT) {
 		if (server_side == kTRUE) SETBIT(db->request.flag1, CLIENT_REQUEST_SERVER_SIDE);
@@ -1296,12 +2007,22 @@ int csql_send_statement (csqldb *db, int command_type, const char *sql, int is_p
 	else if (is_partial == kTRUE)
 		SETBIT(db->request.flag1, CLIENT_PARTIAL_PACKET);
 	
+	if (dest) {
+		SETBIT(db->request.flag1, CLIENT_COMPRESSED_PACKET);
+		db->request.expandedSize = htonl(nsizedim + datasize);
+		return csql_netwrite_buffer(db, NULL, 0, dest, (int)newlen, kTRUE);
+	}
+	
 	return csql_netwrite(db, (char *) field_size, nsizedim, (char *) sql, datasize);
 }
 
 csqlc *csql_read_cursor (csqldb *db, csqlc *existing_c) {
+	return csql_read_cursor_mode(db, existing_c, kFALSE);
+}
+
+csqlc *csql_read_cursor_mode (csqldb *db, csqlc *existing_c, int stream) {
 	csqlc	*c = NULL;
-	int		index, gdone = kFALSE, is_partial = kFALSE;
+	int		index, gdone = kFALSE, is_partial = kFALSE, unacked = kFALSE;
 	int		has_tables, has_rowid, nfields, server_rowcount, server_colcount, cursor_colcount;
 	char	*buffer;
 	int		i, nrows, ncols, count, data_seek = 0, end_chuck;
@@ -1312,6 +2033,7 @@ csqlc *csql_read_cursor (csqldb *db, csqlc *existing_c) {
 	if (existing_c == NULL) {
 		index = 0;
 		c = csql_cursor_alloc(db);
+		if (c) c->stream = stream;
 	}
 	else {
 		index = 1;
@@ -1330,6 +2052,7 @@ csqlc *csql_read_cursor (csqldb *db, csqlc *existing_c) {
 			
 			gdone = kTRUE;
 			if (c->server_side) c->eof = kTRUE;
+			c->stream_pending = kFALSE;
 			//else if (db->client_version == k2007PROTOCOL) csql_ack(db, kCHUNK_OK);
 			continue;
 		}
@@ -1343,6 +2066,9 @@ csqlc *csql_read_cursor (csqldb *db, csqlc *existing_c) {
 		if (TESTBIT(db->reply.flag1, SERVER_SERVER_SIDE)) c->server_side = kTRUE;
 		if (c->server_side) is_partial = kFALSE;
 		
+		// the server waits for a partial chunk to be acknowledged before it sends the next one
+		unacked = ((is_partial == kTRUE) && (c->server_side == kFALSE)) ? kTRUE : kFALSE;
+		
 		nfields = ntohl(db->reply.numFields);
 		server_rowcount = ntohl(db->reply.rows);
 		server_colcount = ntohl(db->reply.cols);
@@ -1363,6 +2089,18 @@ csqlc *csql_read_cursor (csqldb *db, csqlc *existing_c) {
 		}
 		if (server_sum == NULL) goto abort_memory;
 		
+		if ((is_partial) && (c->nbuffer >= c->nalloc)) {
+			if (csql_cursor_reallocate (c) == kFALSE) {free(server_sum); goto abort_memory;}
+		}
+		
+		// the whole chunk has been received and nothing below can fail, so it is acknowledged before
+		// it is decoded: the server produces the next chunk while this one is decoded, and the next chunk
+		// arrives in the socket buffer meanwhile (a streamed cursor acknowledges when the reader asks for more)
+		if ((unacked) && (c->stream == kFALSE)) {
+			unacked = kFALSE;
+			if (csql_ack(db, kCHUNK_OK) != CUBESQL_NOERR) goto abort;
+		}
+		
 		// set buffers
 		server_tables = NULL;
 		if (index == 0) {
@@ -1415,10 +2153,6 @@ csqlc *csql_read_cursor (csqldb *db, csqlc *existing_c) {
 			}
 		}
 		
-		if ((is_partial) && (c->nbuffer >= c->nalloc)) {
-			if (csql_cursor_reallocate (c) == kFALSE) goto abort_memory;
-		}
-		
 		// adjust others counters/pointers
 		if (index == 0) {
 			c->types = server_types;
@@ -1467,9 +2201,13 @@ csqlc *csql_read_cursor (csqldb *db, csqlc *existing_c) {
 		db->inbuffer = NULL;
 		db->insize = 0;
 		
-		// send ACK only in case of chunk cursor
-		if ((is_partial == kTRUE) && (c->server_side == kFALSE)) csql_ack(db, kCHUNK_OK);
-		else gdone = kTRUE;
+		// a streamed cursor returns after each chunk, a chunk cursor goes on with the next one
+		if ((is_partial == kTRUE) && (c->server_side == kFALSE) && (c->stream)) {
+			c->stream_pending = kTRUE;
+			unacked = kFALSE;
+			gdone = kTRUE;
+		}
+		else if (is_partial == kFALSE) gdone = kTRUE;
 		index++;
 	}
 	while (gdone != kTRUE);
@@ -1479,7 +2217,15 @@ abort_memory:
 	csql_seterror(db, CUBESQL_MEMORY_ERROR, "Not enought memory to allocate buffer required to build the cursor");
 	
 abort:
-	if ((c) && (existing_c != NULL)) cubesql_cursor_free(c);
+	// a chunk that failed before its acknowledgement stops the transfer, so the server does not keep
+	// waiting for it; once acknowledged only a network failure can end up here and the socket is gone
+	if (unacked) {
+		if (existing_c) existing_c->stream_pending = kFALSE;
+		csql_ack(db, kCHUNK_ABORT);
+	}
+	
+	// an existing cursor belongs to the caller, only a cursor allocated here can be released
+	if ((c) && (existing_c == NULL)) cubesql_cursor_free(c);
 	return NULL;
 }
 
@@ -1737,11 +2483,19 @@ abort_connect:
 }
 
 int csql_netread (csqldb *db, int expected_size, int expected_nfields, int is_chunk, int *end_chunk, int timeout) {
-	int is_end_chunk = kFALSE;
+	int is_end_chunk = kFALSE, buffered;
+	int64 start;
 	
 	// read header first
 	if (csql_socketread(db, kTRUE, timeout) != CUBESQL_NOERR) return CUBESQL_ERR;
 	
+	// with pipelined requests the first reply arrives late, the shortest time is the round trip
+	start = csql_microtime();
+	if (db->rsent) {
+		if ((db->rstats.rttusec == 0) || (start - db->rsent < db->rstats.rttusec)) db->rstats.rttusec = start - db->rsent;
+		db->rsent = 0;
+	}
+	
 	// check header
 	if (csql_checkheader(db, expected_size, expected_nfields, &is_end_chunk) != CUBESQL_NOERR) return CUBESQL_ERR;
 	
@@ -1749,38 +2503,129 @@ int csql_netread (csqldb *db, int expected_size, int expected_nfields, int is_ch
 	if (end_chunk) *end_chunk = is_end_chunk;
 	if ((is_chunk) && (is_end_chunk)) {*end_chunk = is_end_chunk; return CUBESQL_NOERR;}
 	if (db->toread == 0) return CUBESQL_NOERR;
+	buffered = db->rbufend - db->rbufstart;
+	
+	// check if packet is compressed, it is inflated while it is received
+	if (TESTBIT(db->reply.flag1, SERVER_COMPRESSED_PACKET)) {
+		int64 work = 0, elapsed;
+		
+		if (csql_netread_inflate(db, timeout, &work) != CUBESQL_NOERR) return CUBESQL_ERR;
+		
+		// when decrypting and inflating kept the reader busy, the time measures the CPU and not the network
+		elapsed = csql_microtime() - start;
+		if (work < elapsed / 2) csql_result_bandwidth(db, db->toread - buffered, elapsed);
+		return CUBESQL_NOERR;
+	}
 	
 	// if there is something more to read, then read everything into the inbuffer
 	if (csql_checkinbuffer(db) != CUBESQL_NOERR) return CUBESQL_ERR;
 	if (csql_socketread(db, kFALSE, timeout) != CUBESQL_NOERR) return CUBESQL_ERR;
+	csql_result_bandwidth(db, db->toread - buffered, csql_microtime() - start);
 	
 	// check if packet is encrypted
 	if (db->reply.encryptedPacket != CUBESQL_ENCRYPTION_NONE)
 		decrypt_buffer(db->inbuffer, db->toread, db->decryptkey);
 	
-	// check if packet is compressed
-	if (TESTBIT(db->reply.flag1, SERVER_COMPRESSED_PACKET)) {
-		int		exp_size = ntohl(db->reply.expandedSize);
-		uLong	zExpSize = (uLong)exp_size;
-		char	*buffer;
-		
-		buffer = (char *) malloc(exp_size);
-		if (buffer == NULL) {
+	csql_result_account(db, kFALSE, db->toread, db->toread, 0);
+	return CUBESQL_NOERR;
+}
+
+int csql_netread_inflate (csqldb *db, int timeout, int64 *work) {
+	// a compressed reply is read kINFLATE_WINDOW bytes at a time, decrypted and inflated straight into
+	// the inbuffer that ends up holding the expanded reply (and the cursor built on it): the compressed
+	// reply never exists as a whole, and inflating a window overlaps with the next one arriving
+	int			exp_size = ntohl(db->reply.expandedSize);
+	int			encrypted = (db->reply.encryptedPacket != CUBESQL_ENCRYPTION_NONE);
+	int			nleft = db->toread, nkeep = 0, n, avail, plain, ended = kFALSE, failed = kFALSE, zerr;
+	int64		t, inflate_usec = 0;
+	char		*window;
+	z_stream	*zs;
+	
+	if (exp_size <= 0) {
+		csql_seterror(db, CUBESQL_PROTOCOL_ERROR, "Invalid expanded size of a compressed packet");
+		return CUBESQL_ERR;
+	}
+	
+	if (db->insize < exp_size) {
+		if (db->inbuffer) free(db->inbuffer);
+		db->insize = 0;
+		db->inbuffer = (char *) malloc(exp_size);
+		if (db->inbuffer == NULL) {
 			csql_seterror(db, CUBESQL_MEMORY_ERROR, "Not enought memory to allocate buffer required by the cursor");
 			return CUBESQL_ERR;
 		}
-		
-		if (uncompress((Bytef *)buffer, &zExpSize, (Bytef *)db->inbuffer, (uLong)db->toread) != Z_OK) {
-			csql_seterror(db, CUBESQL_ZLIB_ERROR, "An error occurred while trying to uncompress received cursor");
-			free(buffer);
+	}
+	db->insize = exp_size;
+	
+	// the window also holds the bytes kept back from the previous one
+	window = csql_scratch(db, kINFLATE_WINDOW + 4 * BLOCK_LEN);
+	if (window == NULL) {
+		csql_seterror(db, CUBESQL_MEMORY_ERROR, "Unable to allocate inflate window");
+		return CUBESQL_ERR;
+	}
+	
+	if (db->inflater == NULL) {
+		db->inflater = (z_stream *) calloc(1, sizeof(z_stream));
+		if ((db->inflater == NULL) || (inflateInit(db->inflater) != Z_OK)) {
+			if (db->inflater) free(db->inflater);
+			db->inflater = NULL;
+			csql_seterror(db, CUBESQL_MEMORY_ERROR, "Unable to allocate inflate state");
 			return CUBESQL_ERR;
 		}
+	} else {
+		inflateReset(db->inflater);
+	}
+	zs = db->inflater;
+	zs->next_out = (Bytef *)db->inbuffer;
+	zs->avail_out = (uInt)exp_size;
+	
+	while (nleft > 0) {
+		n = (nleft < kINFLATE_WINDOW) ? nleft : kINFLATE_WINDOW;
+		if (csql_socketreadn(db, window + nkeep, n, timeout) != CUBESQL_NOERR) return CUBESQL_ERR;
+		nleft -= n;
+		n += nkeep;
+		
+		t = csql_microtime();
+		plain = n;
+		nkeep = 0;
+		if (encrypted) {
+			// the window starts with the CBC chaining block, the random pool of the packet in the first one;
+			// whole blocks are decrypted and the last one is kept to chain the next window, and until the end
+			// at least two blocks are left for the ciphertext stealing of a partial last block
+			if (nleft == 0) {
+				decrypt_buffer(window, n, db->decryptkey);
+				plain = n - BLOCK_LEN;
+			} else {
+				avail = n - BLOCK_LEN;
+				plain = avail - (avail % BLOCK_LEN);
+				while ((plain > 0) && (avail - plain + nleft < 2 * BLOCK_LEN)) plain -= BLOCK_LEN;
+				if (plain > 0) decrypt_buffer(window, plain + BLOCK_LEN, db->decryptkey);
+				nkeep = n - plain;
+			}
+		}
+		*work += csql_microtime() - t;
+		
+		// after an error the rest of the reply is still read, so that the connection stays in sync
+		if ((plain > 0) && (ended == kFALSE) && (failed == kFALSE)) {
+			t = csql_microtime();
+			zs->next_in = (Bytef *)window;
+			zs->avail_in = (uInt)plain;
+			zerr = inflate(zs, Z_NO_FLUSH);
+			if (zerr == Z_STREAM_END) ended = kTRUE;
+			else if ((zerr != Z_OK) || (zs->avail_in != 0)) failed = kTRUE;
+			inflate_usec += csql_microtime() - t;
+		}
 		
-		free (db->inbuffer);
-		db->inbuffer = buffer;
-		db->insize = exp_size;
+		if (nkeep > 0) memmove(window, window + plain, nkeep);
 	}
+	*work += inflate_usec;
 	
+	if (ended == kFALSE) {
+		csql_seterror(db, CUBESQL_ZLIB_ERROR, "An error occurred while trying to uncompress received cursor");
+		return CUBESQL_ERR;
+	}
+	
+	csql_result_account(db, kTRUE, db->toread, exp_size, inflate_usec);
 	return CUBESQL_NOERR;
 }
 
@@ -1800,45 +2645,60 @@ int csql_checkinbuffer (csqldb *db) {
 }
 
 int csql_netwrite (csqldb *db, char *size_array, int nsize_array, char *buffer, int nbuffer) {
+	return csql_netwrite_buffer(db, size_array, nsize_array, buffer, nbuffer, kFALSE);
+}
+
+int csql_netwrite_buffer (csqldb *db, char *size_array, int nsize_array, char *buffer, int nbuffer, int is_scratch) {
 	char rand1[kRANDPOOLSIZE], *encbuffer = NULL;
+	struct iovec iov[4];
+	int niov = 0, rc;
 	
-	// send header request
-	if (csql_socketwrite(db, (char *)&db->request, kHEADER_SIZE) != CUBESQL_NOERR) return CUBESQL_ERR;
-	
-	// send size array
-	if (size_array) if (csql_socketwrite(db, size_array, nsize_array) != CUBESQL_NOERR) return CUBESQL_ERR;
+	// header request, size array and buffer are gathered and sent with a single write
+	iov[niov].iov_base = (char *)&db->request;
+	iov[niov++].iov_len = kHEADER_SIZE;
 	
-	// send buffer as is if it's a not encrypted channel
-	if (db->encryption == CUBESQL_ENCRYPTION_NONE) {
-		if (buffer) if (csql_socketwrite(db, buffer, nbuffer) != CUBESQL_NOERR) return CUBESQL_ERR;
-		return CUBESQL_NOERR;
+	if (size_array) {
+		iov[niov].iov_base = size_array;
+		iov[niov++].iov_len = nsize_array;
 	}
 	
-	// case buffer is NULL
-	if (buffer == NULL) return CUBESQL_NOERR;
+	// send buffer as is if it's a not encrypted channel or buffer is NULL
+	if ((db->encryption == CUBESQL_ENCRYPTION_NONE) || (buffer == NULL)) {
+		if (buffer) {
+			iov[niov].iov_base = buffer;
+			iov[niov++].iov_len = nbuffer;
+		}
+		rc = csql_socketwritev(db, iov, niov);
+		if ((rc == CUBESQL_NOERR) && (db->rsent == 0)) db->rsent = csql_microtime();
+		csql_scratch_release(db);
+		return rc;
+	}
 	
-	// generate random pool and encrypt buffer
+	// generate random pool and encrypt buffer, the scratch buffer already holding it is encrypted in place
 	csql_rand_fill(rand1);
-	encbuffer = (char *) malloc (nbuffer+1);
-	if (encbuffer == NULL) {
-		csql_seterror(db, CUBESQL_MEMORY_ERROR, "Unable to allocate encbuffer");
-		return CUBESQL_ERR;
+	if (is_scratch) {
+		encbuffer = buffer;
+	} else {
+		encbuffer = csql_scratch(db, nbuffer+1);
+		if (encbuffer == NULL) {
+			csql_seterror(db, CUBESQL_MEMORY_ERROR, "Unable to allocate encbuffer");
+			return CUBESQL_ERR;
+		}
+		memcpy (encbuffer, buffer, nbuffer);
 	}
-	memcpy (encbuffer, buffer, nbuffer);
 	encrypt_buffer ((char *)encbuffer, nbuffer, rand1, db->encryptkey);
 	
-	// send random pool
-	if (csql_socketwrite(db, rand1, BLOCK_LEN) != CUBESQL_NOERR) goto abort;
+	// random pool followed by the encrypted buffer
+	iov[niov].iov_base = rand1;
+	iov[niov++].iov_len = BLOCK_LEN;
+	iov[niov].iov_base = encbuffer;
+	iov[niov++].iov_len = nbuffer;
 	
-	// send encrypted buffer
-	if (csql_socketwrite(db, encbuffer, nbuffer) != CUBESQL_NOERR) goto abort;
+	rc = csql_socketwritev(db, iov, niov);
+	if ((rc == CUBESQL_NOERR) && (db->rsent == 0)) db->rsent = csql_microtime();
 	
-	if (encbuffer) free(encbuffer);
-	return CUBESQL_NOERR;
-
-abort:
-	if (encbuffer) free(encbuffer);
-	return CUBESQL_ERR;
+	csql_scratch_release(db);
+	return rc;
 }
 
 int csql_sendchunk (csqldb *db, char *buffer, int bufferlen, int buffertype, int is_bind) {
@@ -1851,15 +2711,19 @@ int csql_sendchunk (csqldb *db, char *buffer, int bufferlen, int buffertype, int
 	bsize = bufferlen;
 	is_compressed = kFALSE;
 	
-	// try to compress buffer, in case of error just use the uncompressed one
-	newlen = compressBound(bufferlen);;
-	dest = (char *) malloc (newlen);
-	if (dest != NULL) {
-		if (compress2((Bytef*)dest, &newlen, (Bytef*)buffer, (uLong)bufferlen, Z_DEFAULT_COMPRESSION) == Z_OK) {
-			b = dest;
-			bsize = (int)newlen;
-			is_compressed = kTRUE;
-		} else {free(dest); dest = NULL;}
+	// try to compress buffer when the policy expects it to pay off, in case of error
+	// (or when it does not get smaller) just use the uncompressed one
+	if (csql_compress_check(db, buffer, bufferlen)) {
+		newlen = compressBound(bufferlen);
+		dest = csql_scratch(db, (int)newlen+1);
+		if ((dest != NULL) && (csql_compress(db, dest, &newlen, NULL, 0, buffer, (uLong)bufferlen) == Z_OK)) {
+			csql_compress_account(db, bufferlen, (int)newlen);
+			if (newlen < (uLong)bufferlen) {
+				b = dest;
+				bsize = (int)newlen;
+				is_compressed = kTRUE;
+			} else dest = NULL;
+		} else dest = NULL;
 	}
 	
 	// build packet, the chunk command never sends the field_size, nfield should be set to 1
@@ -1875,12 +2739,200 @@ int csql_sendchunk (csqldb *db, char *buffer, int bufferlen, int buffertype, int
 		db->request.expandedSize = htonl(bufferlen);
 	}
 	
-	err = csql_netwrite(db, NULL, 0, b, bsize);
-	if (dest != NULL) free(b);
+	// the compressed copy is in the scratch buffer and can be encrypted in place, the caller's buffer is only read
+	err = csql_netwrite_buffer(db, NULL, 0, b, bsize, (dest != NULL));
 	
 	return err;
 }
 
+int csql_compress (csqldb *db, char *dest, uLong *destlen, const char *head, int headlen, const char *source, uLong sourcelen) {
+	// same output as compress2 at the level of the connection for head followed by source, but the
+	// deflate state of the connection is reset and reused instead of being allocated again every time
+	z_stream *stream = db->deflater;
+	int err;
+	
+	if (stream == NULL) {
+		stream = (z_stream *) calloc(1, sizeof(z_stream));
+		if (stream == NULL) return Z_MEM_ERROR;
+		if ((err = deflateInit(stream, db->zlevel)) != Z_OK) {free(stream); return err;}
+		db->deflater = stream;
+		db->zdeflatelevel = db->zlevel;
+	} else {
+		if ((err = deflateReset(stream)) != Z_OK) return err;
+		if (db->zdeflatelevel != db->zlevel) {
+			if ((err = deflateParams(stream, db->zlevel, Z_DEFAULT_STRATEGY)) != Z_OK) return err;
+			db->zdeflatelevel = db->zlevel;
+		}
+	}
+	
+	stream->next_out = (Bytef *)dest;
+	stream->avail_out = (uInt)*destlen;
+	
+	if (headlen > 0) {
+		stream->next_in = (Bytef *)head;
+		stream->avail_in = (uInt)headlen;
+		if ((err = deflate(stream, Z_NO_FLUSH)) != Z_OK) return err;
+	}
+	
+	stream->next_in = (Bytef *)source;
+	stream->avail_in = (uInt)sourcelen;
+	
+	err = deflate(stream, Z_FINISH);
+	if (err != Z_STREAM_END) return (err == Z_OK) ? Z_BUF_ERROR : err;
+	
+	*destlen = stream->total_out;
+	return Z_OK;
+}
+
+int csql_compress_check (csqldb *db, const char *buffer, int len) {
+	// compression policy of the connection: kTRUE when buffer is worth compressing
+	if ((db->zlevel == 0) || (len < db->zminsize)) return kFALSE;
+	
+	// poor ratios in a row turn compression off for the next few packets
+	if (db->zbackoff > 0) {
+		db->zbackoff--;
+		db->zskipped++;
+		return kFALSE;
+	}
+	
+	// already compressed data (JPEG, ZIP, ...) has nearly uniform byte frequencies, a chi-square test on a
+	// sample from the middle of the buffer (past any file header) detects it without running deflate
+	if (len >= 2 * kCOMPRESS_SAMPLE) {
+		const unsigned char *p = (const unsigned char *)buffer + (len - kCOMPRESS_SAMPLE) / 2;
+		int count[256] = {0}, i;
+		double chi = 0, expected = kCOMPRESS_SAMPLE / 256.0;
+		
+		for (i=0; i<kCOMPRESS_SAMPLE; ++i) count[p[i]]++;
+		for (i=0; i<256; ++i) chi += (count[i] - expected) * (count[i] - expected) / expected;
+		
+		if (chi < kCOMPRESS_UNIFORM) {
+			db->zskipped++;
+			return kFALSE;
+		}
+	}
+	
+	return kTRUE;
+}
+
+void csql_compress_account (csqldb *db, int len, int newlen) {
+	// statistics and back-off of the compression policy
+	db->zbytesin += len;
+	db->zbytesout += (newlen < len) ? newlen : len;
+	
+	if ((int64)newlen * 100 < (int64)len * kCOMPRESS_POOR) {
+		db->zpoor = 0;
+	} else if (++db->zpoor >= kCOMPRESS_POOR_RUN) {
+		db->zpoor = 0;
+		db->zbackoff = kCOMPRESS_BACKOFF;
+	}
+}
+
+int csql_result_advertise (csqldb *db) {
+	int mode = (db->rquery != CUBESQL_COMPRESSION_DEFAULT) ? db->rquery : db->rmode;
+	
+	if (mode == CUBESQL_COMPRESSION_OFF) return kFALSE;
+	if (mode == CUBESQL_COMPRESSION_ON) return kTRUE;
+	
+	// auto mode advertises until the connection has been measured, and then every kRESULT_PROBE
+	// requests so that the compression ratio of the replies keeps being sampled
+	if ((db->rinflate == 0) || (db->rstats.bandwidth == 0)) return kTRUE;
+	if (--db->rprobe <= 0) {
+		db->rprobe = kRESULT_PROBE;
+		return kTRUE;
+	}
+	
+	// compression pays off when the transfer time it saves on each expanded byte
+	// is longer than the time uncompress takes for it
+	return ((1.0 - db->rratio) * 1000000.0 / (double)db->rstats.bandwidth > db->rinflate) ? kTRUE : kFALSE;
+}
+
+void csql_result_request (csqldb *db) {
+	// decided once for each request that produces a result: the requests that continue it
+	// (binds, chunk acks, cursor steps and closes) carry the same flag and leave the probe alone
+	db->rstats.advertising = csql_result_advertise(db);
+}
+
+void csql_result_account (csqldb *db, int compressed, int len, int explen, int64 usec) {
+	// statistics of the replies and running averages of the compression ratio and uncompress speed,
+	// only large replies take long enough to be timed reliably
+	csqlresultstats *stats = &db->rstats;
+	
+	if (compressed) {
+		stats->compressed++;
+		stats->bytescompressed += len;
+		stats->bytesexpanded += explen;
+		stats->inflateusec += usec;
+		
+		if (explen >= kRESULT_SAMPLE) {
+			double cost = (double)usec / explen, ratio = (double)len / explen;
+			db->rinflate = (db->rinflate == 0) ? cost : (db->rinflate * 7 + cost) / 8;
+			db->rratio = (db->rratio == 0) ? ratio : (db->rratio * 7 + ratio) / 8;
+		}
+	} else {
+		stats->uncompressed++;
+		stats->bytesuncompressed += len;
+		if ((stats->advertising == kFALSE) && (len >= kCOMPRESS_MIN)) stats->savedusec += (int64)(len * db->rinflate);
+	}
+}
+
+void csql_result_bandwidth (csqldb *db, int len, int64 usec) {
+	// bytes read after the reply header over the time they took, once the first
+	// segment has arrived this is the rate the network delivers the rest at
+	double sample;
+	
+	if ((len < kRESULT_SAMPLE) || (usec <= 0)) return;
+	sample = (double)len * 1000000.0 / (double)usec;
+	db->rstats.bandwidth = (db->rstats.bandwidth == 0) ? (int64)sample : (int64)((db->rstats.bandwidth * 7 + sample) / 8);
+}
+
+int64 csql_microtime (void) {
+	// monotonic clock in microseconds
+	#ifdef WIN32
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER now;
+	
+	if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&now);
+	return (int64)((now.QuadPart / frequency.QuadPart) * 1000000 + (now.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart);
+	#else
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+	#endif
+}
+
+char *csql_scratch (csqldb *db, int size) {
+	// buffer of the connection reused by the send path for compressed and encrypted output and by
+	// csql_netread_inflate as its window, it grows geometrically so that the steady state does not allocate at all
+	int newsize;
+	
+	if (size <= db->scratchsize) return db->scratch;
+	
+	newsize = (db->scratchsize > 0) ? db->scratchsize : kSCRATCH_MIN;
+	while (newsize < size) {
+		if (newsize > INT_MAX / 2) {newsize = size; break;}
+		newsize *= 2;
+	}
+	
+	if (db->scratch) free(db->scratch);
+	db->scratchsize = 0;
+	db->scratch = (char *) malloc(newsize);
+	if (db->scratch == NULL) return NULL;
+	
+	db->scratchsize = newsize;
+	return db->scratch;
+}
+
+void csql_scratch_release (csqldb *db) {
+	// a scratch buffer grown above kSCRATCH_CAP by a large request is not kept for the next one
+	if (db->scratchsize <= kSCRATCH_CAP) return;
+	
+	free(db->scratch);
+	db->scratch = NULL;
+	db->scratchsize = 0;
+}
+
 char *csql_receivechunk (csqldb *db, int *len, int *is_end_chunk) {
 	int err = csql_netread(db, -1, -1, kTRUE, is_end_chunk, NO_TIMEOUT);
 	if (err == CUBESQL_ERR) csql_ack(db, kCHUNK_ABORT);
@@ -1911,28 +2963,17 @@ read_reply:
 	return csql_netread(db, -1, -1, kFALSE, NULL, NO_TIMEOUT);
 }
 
-int csql_socketwrite (csqldb *db, const char *buffer, int nbuffer) {
-	int fd, ret, nwritten, nleft = nbuffer;
-	const char *ptr = buffer;
-	fd_set except_fds;
-	fd_set write_fds;
-	struct timeval tv;
+int csql_socketwait (csqldb *db) {
+	// waits until the socket is writable, at most db->timeout seconds
+	int ret, fd = db->sockfd;
+	short revents;
 	
-	fd = db->sockfd;
-	while (nleft > 0) {
-		FD_ZERO(&write_fds);
-		FD_SET(fd, &write_fds);
-		FD_ZERO(&except_fds);
-		FD_SET(fd, &except_fds);
-		
-		tv.tv_sec = db->timeout;
-		tv.tv_usec = 0;
-		
-		ret = bsd_select(fd+1, NULL, &write_fds, &except_fds, &tv);
+	while (1) {
+		ret = csql_socketpoll(fd, POLLOUT, db->timeout * 1000, &revents);
 		
 		// something wrong occurred
-		if (FD_ISSET(fd, &except_fds)) {
-			csql_seterror(db, ERR_SOCKET, "select returns except_fds inside csql_socketwrite");
+		if ((ret > 0) && (revents & (POLLERR | POLLHUP | POLLNVAL))) {
+			csql_seterror(db, ERR_SOCKET, "poll returns an error condition inside csql_socketwrite");
 			return CUBESQL_ERR;
 		}
 		
@@ -1951,34 +2992,100 @@ int csql_socketwrite (csqldb *db, const char *buffer, int nbuffer) {
 			return CUBESQL_ERR;
 		}
 		
-		if (FD_ISSET(fd, &write_fds)) {
-			FD_CLR(fd, &write_fds);
-			
-			#ifndef CUBESQL_DISABLE_SSL_ENCRYPTION
-			nwritten = (db->tls_context) ? (int)tls_write(db->tls_context, ptr, nleft) : (int)sock_write(fd, ptr, nleft);
-			#else
-			nwritten = (int)sock_write(fd, ptr, nleft);
-			#endif
+		if (revents & POLLOUT) return CUBESQL_NOERR;
+	}
+}
+
+int csql_socketwrite (csqldb *db, const char *buffer, int nbuffer) {
+	int fd, nwritten, nleft = nbuffer;
+	const char *ptr = buffer;
+	
+	fd = db->sockfd;
+	while (nleft > 0) {
+		if (csql_socketwait(db) != CUBESQL_NOERR) return CUBESQL_ERR;
+		
+		#ifndef CUBESQL_DISABLE_SSL_ENCRYPTION
+		nwritten = (db->tls_context) ? (int)tls_write(db->tls_context, ptr, nleft) : (int)sock_write(fd, ptr, nleft);
+		#else
+		nwritten = (int)sock_write(fd, ptr, nleft);
+		#endif
+		
+		if (nwritten <= 0) {
+			csql_seterror(db, ERR_SOCKET_WRITE, "An error occurred while trying to execute sock_write");
+			return CUBESQL_ERR;
+		}
+		
+		nleft -= nwritten;
+		ptr += nwritten;
+	}
+	
+	return CUBESQL_NOERR;
+}
 
+int csql_socketwritev (csqldb *db, struct iovec *iov, int iovcnt) {
+	// a plain socket sends all the pieces with writev (iov is consumed), TLS and Windows
+	// coalesce them into as few writes, and so TLS records, as possible
+	int i;
+	
+	#if !defined(WIN32)
+	#ifndef CUBESQL_DISABLE_SSL_ENCRYPTION
+	if (db->tls_context == NULL)
+	#endif
+	{
+		int nwritten;
+		
+		while (iovcnt > 0) {
+			if (iov->iov_len == 0) {++iov; --iovcnt; continue;}
+			if (csql_socketwait(db) != CUBESQL_NOERR) return CUBESQL_ERR;
+			
+			nwritten = (int)writev(db->sockfd, iov, iovcnt);
 			if (nwritten <= 0) {
-				csql_seterror(db, ERR_SOCKET_WRITE, "An error occurred while trying to execute sock_write");
+				csql_seterror(db, ERR_SOCKET_WRITE, "An error occurred while trying to execute writev");
 				return CUBESQL_ERR;
 			}
 			
-			nleft -= nwritten;
-			ptr += nwritten;
+			// skip what has been written, a partial write resumes inside a piece
+			while ((iovcnt > 0) && (nwritten >= (int)iov->iov_len)) {
+				nwritten -= (int)iov->iov_len;
+				++iov; --iovcnt;
+			}
+			if (iovcnt > 0) {
+				iov->iov_base = (char *)iov->iov_base + nwritten;
+				iov->iov_len -= nwritten;
+			}
+		}
+		return CUBESQL_NOERR;
+	}
+	#endif
+	
+	char	coalesced[kCOALESCE_WRITE];
+	int		ncoalesced = 0;
+	
+	for (i=0; i<iovcnt; ++i) {
+		int len = (int)iov[i].iov_len;
+		
+		if (ncoalesced + len > kCOALESCE_WRITE) {
+			if (ncoalesced > 0 && csql_socketwrite(db, coalesced, ncoalesced) != CUBESQL_NOERR) return CUBESQL_ERR;
+			ncoalesced = 0;
+			
+			// large pieces are sent from where they are
+			if (len >= kCOALESCE_WRITE) {
+				if (csql_socketwrite(db, (const char *)iov[i].iov_base, len) != CUBESQL_NOERR) return CUBESQL_ERR;
+				continue;
+			}
 		}
+		
+		memcpy(coalesced + ncoalesced, iov[i].iov_base, len);
+		ncoalesced += len;
 	}
 	
+	if (ncoalesced > 0) return csql_socketwrite(db, coalesced, ncoalesced);
 	return CUBESQL_NOERR;
 }
 
 int csql_socketread (csqldb *db, int is_header, int timeout) {
-	int		nread, nleft, ret, fd = db->sockfd;
+	int		nleft;
 	char	*ptr;
-	fd_set read_fds;
-	fd_set except_fds;
-	struct timeval tv;
 	
 	if (is_header == kTRUE) {
 		ptr = (char *)&db->reply;
@@ -1989,22 +3096,29 @@ int csql_socketread (csqldb *db, int is_header, int timeout) {
 		nleft = db->toread;
 	}
 	
-	while (1) {
-		FD_ZERO(&read_fds);
-		FD_SET(fd, &read_fds);
-		FD_ZERO(&except_fds);
-		FD_SET(fd, &except_fds);
-		
-		if (timeout != NO_TIMEOUT) {
-			tv.tv_sec = timeout;
-			tv.tv_usec = 0;
-			ret = bsd_select(fd+1, &read_fds, NULL, &except_fds, &tv);
-		} else
-			ret = bsd_select(fd+1, &read_fds, NULL, &except_fds, NULL);
-		
-		if (FD_ISSET(fd, &except_fds)) {
-			// this may only happen on Windows
-			csql_seterror(db, ERR_SOCKET_READ, "select returns except_fds inside csql_socketread");
+	return csql_socketreadn(db, ptr, nleft, timeout);
+}
+
+int csql_socketreadn (csqldb *db, char *ptr, int nleft, int timeout) {
+	int		nread, ret, fd = db->sockfd;
+	short	revents;
+	
+	// hand over what a previous read has already received, without waiting on the socket
+	nread = db->rbufend - db->rbufstart;
+	if (nread > 0) {
+		if (nread > nleft) nread = nleft;
+		memcpy(ptr, db->rbuffer + db->rbufstart, nread);
+		db->rbufstart += nread;
+		nleft -= nread;
+		ptr += nread;
+	}
+	
+	while (nleft > 0) {
+		ret = csql_socketpoll(fd, POLLIN, (timeout != NO_TIMEOUT) ? timeout * 1000 : -1, &revents);
+		
+		// POLLERR and POLLHUP are left to sock_read, data may still be waiting before the error or hang up
+		if ((ret > 0) && (revents & POLLNVAL)) {
+			csql_seterror(db, ERR_SOCKET_READ, "poll returns an invalid descriptor inside csql_socketread");
 			return CUBESQL_ERR;
 		}
 		
@@ -2022,12 +3136,7 @@ int csql_socketread (csqldb *db, int is_header, int timeout) {
 			return CUBESQL_ERR;
 		}
 		
-		#ifndef CUBESQL_DISABLE_SSL_ENCRYPTION
-		nread = (db->tls_context) ? (int)tls_read(db->tls_context, ptr, nleft) : (int)sock_read(fd, ptr, nleft);
-		#else
-		nread = (int)sock_read(fd, ptr, nleft);
-		#endif
-		
+		nread = csql_socketrecv(db, ptr, nleft);
 		if (nread == -1 || nread == 0) {
 			csql_seterror(db, ERR_SOCKET_READ, "An error occurred while executing sock_read");
 			return CUBESQL_ERR;
@@ -2035,19 +3144,81 @@ int csql_socketread (csqldb *db, int is_header, int timeout) {
 		
 		nleft -= nread;
 		ptr += nread;
-		
-		if (nleft == 0)
-			return CUBESQL_NOERR;
 	}
 	
 	return CUBESQL_NOERR;
 }
 
+int csql_socketrecv (csqldb *db, char *ptr, int nleft) {
+	// one read from the socket, returns the bytes stored in ptr
+	// small reads fill the receive buffer with as much as the socket has, so the headers and payloads
+	// that follow are parsed out of it without further syscalls; large payloads are read straight into ptr
+	int fd = db->sockfd, nread;
+	
+	if (db->rbuffer == NULL) {
+		db->rbuffer = (char *) malloc(kRECV_BUFFER);
+		if (db->rbuffer == NULL) return -1;
+	}
+	db->rbufstart = db->rbufend = 0;
+	
+	if (nleft < kRECV_BUFFER) {
+		#ifndef CUBESQL_DISABLE_SSL_ENCRYPTION
+		nread = (db->tls_context) ? (int)tls_read(db->tls_context, db->rbuffer, kRECV_BUFFER) : (int)sock_read(fd, db->rbuffer, kRECV_BUFFER);
+		#else
+		nread = (int)sock_read(fd, db->rbuffer, kRECV_BUFFER);
+		#endif
+		if (nread <= 0) return nread;
+		
+		db->rbufend = nread;
+		if (nread > nleft) nread = nleft;
+		memcpy(ptr, db->rbuffer, nread);
+		db->rbufstart = nread;
+		return nread;
+	}
+	
+	#ifndef CUBESQL_DISABLE_SSL_ENCRYPTION
+	if (db->tls_context) return (int)tls_read(db->tls_context, ptr, nleft);
+	#endif
+	
+	#ifdef WIN32
+	return (int)sock_read(fd, ptr, nleft);
+	#else
+	// the receive buffer picks up what the server sent after the payload
+	struct iovec iov[2];
+	iov[0].iov_base = ptr;
+	iov[0].iov_len = nleft;
+	iov[1].iov_base = db->rbuffer;
+	iov[1].iov_len = kRECV_BUFFER;
+	
+	nread = (int)readv(fd, iov, 2);
+	if (nread > nleft) {
+		db->rbufend = nread - nleft;
+		nread = nleft;
+	}
+	return nread;
+	#endif
+}
+
 void csql_seterror(csqldb *db, int errcode, const char *errmsg) {
 	db->errcode = errcode;
 	strncpy(db->errmsg, errmsg, sizeof(db->errmsg));
 }
 
+int csql_socketpoll (int fd, short events, int timeout, short *revents) {
+	// timeout is in milliseconds, -1 waits forever
+	// poll has no FD_SETSIZE limit on the descriptor value, unlike select
+	struct pollfd pfd;
+	int ret;
+	
+	pfd.fd = fd;
+	pfd.events = events;
+	pfd.revents = 0;
+	
+	ret = bsd_poll(&pfd, 1, timeout);
+	*revents = (ret > 0) ? pfd.revents : 0;
+	return ret;
+}
+
 int csql_socketerror (int fd) {
 	int			err, sockerr, err2;
 	socklen_t	errlen = sizeof(err);
@@ -2145,7 +3316,7 @@ void csql_initrequest (csqldb *db, int packetsize, int nfields, char command, ch
 	request->command = command;
 	request->selector = selector;
 	request->flag1 = kEMPTY_FIELD;
-	SETBIT(request->flag1, CLIENT_SUPPORT_COMPRESSION);
+	if (db->rstats.advertising) SETBIT(request->flag1, CLIENT_SUPPORT_COMPRESSION);
 	request->flag2 = kEMPTY_FIELD;
 	request->flag3 = kEMPTY_FIELD;
 	request->encryptedPacket = db->encryption;
@@ -2218,19 +3389,45 @@ int csql_cursor_reallocate (csqlc *c) {
 }
 
 int csql_cursor_step (csqlc *c) {
-	// prepare header request
-	csql_initrequest(c->db, 0, 0, kCOMMAND_CURSOR_STEP, kNO_SELECTOR);
+	int window = (c->prefetch > 1) ? c->prefetch : 1;
 	
-	// send header request
-	if (csql_socketwrite(c->db, (char *)&c->db->request, kHEADER_SIZE) != CUBESQL_NOERR) return CUBESQL_ERR;
+	// keep a window of step requests in flight, so the next rows are already on their way
+	// (or waiting in the socket buffer) while the application consumes the current one
+	while (c->inflight < window) {
+		// prepare header request
+		csql_initrequest(c->db, 0, 0, kCOMMAND_CURSOR_STEP, kNO_SELECTOR);
+		
+		// send header request
+		if (csql_socketwrite(c->db, (char *)&c->db->request, kHEADER_SIZE) != CUBESQL_NOERR) return CUBESQL_ERR;
+		c->inflight++;
+	}
 	
 	// receive row
+	c->inflight--;
 	if (csql_read_cursor(c->db, c) == NULL) return CUBESQL_ERR;
 	
+	// steps sent past the end of the cursor still get a reply, which carries nothing of interest
+	if (c->eof) {
+		csql_cursor_drain(c);
+		cubesql_clear_errors(c->db);
+	}
+	
+	return CUBESQL_NOERR;
+}
+
+int csql_cursor_drain (csqlc *c) {
+	// read and discard the replies to the step requests still in flight
+	while (c->inflight > 0) {
+		c->inflight--;
+		if (csql_netread(c->db, -1, -1, kFALSE, NULL, NO_TIMEOUT) != CUBESQL_NOERR) return CUBESQL_ERR;
+	}
 	return CUBESQL_NOERR;
 }
 
 int csql_cursor_close (csqlc *c) {
+	// the connection must be back in sync before the close request
+	csql_cursor_drain(c);
+	
 	// prepare header request
 	csql_initrequest(c->db, 0, 0, kCOMMAND_CURSOR_CLOSE, kNO_SELECTOR);
 	
@@ -2363,7 +3560,14 @@ int encrypt_buffer (char *buffer, int dim, char random[], csql_aes_encrypt_ctx c
 	b2 = buffer;
 	len = dim;
 	
-	do {				
+	if (ctx->ni) {
+		// AES-NI encrypts all the whole blocks in one pass, b1 is left on the last one
+		index = dim / BLOCK_LEN;
+		csql_aesni_cbc_encrypt((unsigned char*)buffer, index, (const unsigned char*)random, ctx);
+		b1 = buffer + ((index - 1) * BLOCK_LEN);
+		len = dim - (index * BLOCK_LEN);
+	}
+	else do {
 		// do CBC chaining prior to encryption for current block (in b2)
 		for(i = 0; i < BLOCK_LEN; ++i)
 			b1[i] ^= b2[i];
@@ -2437,6 +3641,19 @@ int decrypt_buffer (char *buffer, int dim, csql_aes_decrypt_ctx ctx[1]) {
 	b2 = b1 + BLOCK_LEN;
 	len = dim - BLOCK_LEN;
 	
+	if (ctx->ni) {
+		// the blocks before a partial last one do not depend on each other, AES-NI decrypts them
+		// several at a time and the loop below only handles the ciphertext stealing at the end
+		index = (len % BLOCK_LEN) ? (len / BLOCK_LEN) - 1 : (len / BLOCK_LEN);
+		csql_aesni_cbc_decrypt((unsigned char*)buffer, index, ctx);
+		
+		len -= index * BLOCK_LEN;
+		if (len == 0) return 0;
+		
+		b1 = buffer + (index * BLOCK_LEN);
+		b2 = b1 + BLOCK_LEN;
+	}
+	
 	do {
 		nextlen = len - BLOCK_LEN;
 		if (nextlen > BLOCK_LEN) nextlen = BLOCK_LEN;
@@ -61,6 +61,12 @@ extern "C" {
 #define CUBESQL_ENCRYPTION_SSL_AES128       CUBESQL_ENCRYPTION_SSL+CUBESQL_ENCRYPTION_AES128
 #define CUBESQL_ENCRYPTION_SSL_AES192       CUBESQL_ENCRYPTION_SSL+CUBESQL_ENCRYPTION_AES192
 #define CUBESQL_ENCRYPTION_SSL_AES256       CUBESQL_ENCRYPTION_SSL+CUBESQL_ENCRYPTION_AES256
+
+// result compression modes used in cubesql_set_result_compression
+#define CUBESQL_COMPRESSION_DEFAULT         -1
+#define CUBESQL_COMPRESSION_OFF             0
+#define CUBESQL_COMPRESSION_ON              1
+#define CUBESQL_COMPRESSION_AUTO            2
 	
 // flag used in cubesql_cursor_getfield
 #define	CUBESQL_COLNAME                     0
@@ -167,6 +173,20 @@ CUBESQL_APIEXPORT char		*cubesql_cursor_cstring (csqlc *c, int row, int column);
 CUBESQL_APIEXPORT char		*cubesql_cursor_cstring_static (csqlc *c, int row, int column, char *static_buffer, int bufferlen);	
 CUBESQL_APIEXPORT void		cubesql_cursor_free (csqlc *c);
 
+// statistics of the replies received on a connection, see cubesql_result_stats
+typedef struct {
+	int64	compressed;				// replies received compressed
+	int64	uncompressed;			// replies received uncompressed
+	int64	bytescompressed;		// bytes received for the compressed replies
+	int64	bytesexpanded;			// size of the compressed replies once expanded
+	int64	bytesuncompressed;		// bytes received for the uncompressed replies
+	int64	inflateusec;			// time spent expanding replies
+	int64	savedusec;				// estimated expanding time saved by withholding compression support
+	int64	bandwidth;				// estimated bytes per second received, 0 until measured
+	int64	rttusec;				// shortest time from a request to its reply header
+	int		advertising;			// whether the last statement or VM call advertised compression support
+} csqlresultstats;
+	
 // private functions
 int		cubesql_connect_token (csqldb **db, const char *host, int port, const char *username, const char *password,
 							   int timeout, int encryption, char *token, int useOldProtocol, const char *ssl_certificate,
@@ -174,15 +194,43 @@ int		cubesql_connect_token (csqldb **db, const char *host, int port, const char
 int		cubesql_connect_old_protocol (csqldb **db, const char *host, int port, const char *username, const char *password, int timeout, int encryption);
 void	cubesql_clear_errors (csqldb *db);
 csqldb	*cubesql_cursor_db (csqlc *cursor);
+csqldb	*cubesql_vm_db (csqlvm *vm);
+void	cubesql_vmfree (csqlvm *vm);
+int		cubesql_execute_batch (csqldb *db, int nstatements, const char **sql, int *is_select, csqlc **cursors, int *errcodes, char **errmsgs);
+int		cubesql_execute_ex (csqldb *db, const char *sql, int64 *changes, int64 *rowid);
+void	cubesql_set_compression (csqldb *db, int level, int min_size, int statements);
+void	cubesql_compression_stats (csqldb *db, int64 *bytes_in, int64 *bytes_out, int64 *skipped);
+void	cubesql_set_result_compression (csqldb *db, int mode);
+void	cubesql_set_query_compression (csqldb *db, int mode);
+void	cubesql_result_stats (csqldb *db, csqlresultstats *stats);
+int64	cubesql_vm_reprepared (csqldb *db);
+int		cubesql_vmbind_value (csqlvm *vm, int index, int bindtype, char *value, int len);
+int		cubesql_vmbind_execute (csqlvm *vm, int nparams, int *bindtype, char **value, int *len, int *errcodes, int *failed);
+csqlc	*cubesql_vmbind_select (csqlvm *vm, int nparams, int *bindtype, char **value, int *len, int *errcodes, int *failed);
+int		cubesql_vmexecute_many (csqlvm *vm, int nrows, int nparams, int *bindtype, char **value, int *len, int64 *changes, int *failed_row, int *failed_param);
 csqlc	*cubesql_cursor_create (csqldb *db, int nrows, int ncolumns, int *types, char **names);
 int		cubesql_cursor_addrow (csqlc *cursor, char **row, int *len);
 int		cubesql_cursor_columntypebind (csqlc *c, int index);
+void	cubesql_cursor_setprefetch (csqlc *c, int nrows);
+int		cubesql_cursor_isserverside (csqlc *c);
+int		cubesql_cursor_isstream (csqlc *c);
+csqlc	*cubesql_select_stream (csqldb *db, const char *sql);
+int		cubesql_cursor_stream_next (csqlc *c);
+int		cubesql_cursor_stream_pending (csqlc *c);
+int		cubesql_cursor_stream_abort (csqlc *c);
+void	cubesql_cursor_detach (csqlc *c);
+int		cubesql_cursor_numchunks (csqlc *c);
+int		cubesql_cursor_chunk (csqlc *c, int index, char **data, int **size, int **sum, int *nfields);
+int		cubesql_cursor_column_int64 (csqlc *c, int column, int64 *values, unsigned char *nulls);
+int		cubesql_cursor_column_int (csqlc *c, int column, int *values, unsigned char *nulls);
+int		cubesql_cursor_column_double (csqlc *c, int column, double *values, unsigned char *nulls);
 void	cubesql_setuserptr (csqldb *db, void *userptr);
 void	*cubesql_getuserptr (csqldb *db);
 void	cubesql_settoken (csqldb *db, char *token);
 void	cubesql_sethostverification (csqldb *db, char *hostverification);
 char	*cubesql_gettoken (csqldb *db);
 void	cubesql_seterror (csqldb *db, int errcode, const char *errmsg);
+int		cubesql_isneterror (int errcode);
 	
 const char *cubesql_sslversion (void);
 unsigned long cubesql_sslversion_num (void);
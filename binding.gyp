@@ -11,6 +11,7 @@
         "CubeSQL-SDK/C_SDK/cubesql.c",
         "CubeSQL-SDK/C_SDK/crypt/aescrypt.c",
         "CubeSQL-SDK/C_SDK/crypt/aeskey.c",
+        "CubeSQL-SDK/C_SDK/crypt/aesni.c",
         "CubeSQL-SDK/C_SDK/crypt/aestab.c",
         "CubeSQL-SDK/C_SDK/crypt/base64.c",
         "CubeSQL-SDK/C_SDK/crypt/pseudorandom.c",
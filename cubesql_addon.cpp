@@ -1,14 +1,3362 @@
 #include <napi.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <uv.h>
 #include "CubeSQL-SDK/C_SDK/cubesql.h"
 
+class ConnectionWorker;
+
+// Fixed-size ring for exactly one producer thread and one consumer thread,
+// synchronized by the two indices alone
+template <typename T, size_t N>
+class SpscQueue {
+public:
+    bool Push(T value) {
+        size_t last = tail.load(std::memory_order_relaxed);
+        size_t next = (last + 1) % N;
+        if (next == head.load(std::memory_order_acquire)) return false;
+        slots[last] = value;
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T* value) {
+        size_t first = head.load(std::memory_order_relaxed);
+        if (first == tail.load(std::memory_order_acquire)) return false;
+        *value = slots[first];
+        head.store((first + 1) % N, std::memory_order_release);
+        return true;
+    }
+
+    bool Empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    T slots[N];
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+// A thread of its own for one connection (setDedicatedThread). Calls reach it through a lock-free queue
+// and run there instead of on the libuv threadpool, so long round trips do not hold the few threadpool
+// threads that fs, crypto and dns work need. Completed calls come back through a second queue and the
+// JS thread is woken once for all completions that are ready, not once per call. The mutex only parks
+// the thread while there is nothing to do. The Connection owns the object; an environment cleanup hook
+// stops the thread when Node shuts down before the connection is gone.
+class IOThread {
+public:
+    explicit IOThread(Napi::Env env) : env(env) {
+        tsfn = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}), "cubesql_io", 0, 1);
+        // only calls in flight keep the process alive
+        tsfn.Unref(env);
+        thread = std::thread(&IOThread::Loop, this);
+        napi_add_env_cleanup_hook(env, Cleanup, this);
+    }
+
+    ~IOThread() {
+        Stop();
+    }
+
+    // JS thread. A connection runs one call at a time, so the queue never fills up.
+    void Submit(Napi::AsyncWorker* worker) {
+        if (inflight++ == 0) tsfn.Ref(env);
+        requests.Push(worker);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+        }
+        wakeup.notify_one();
+    }
+
+    // JS thread, with no call in flight. A wakeup is only ever posted for a completion that
+    // has not been settled yet, so none is left behind to run once the object is gone.
+    void Stop() {
+        if (!thread.joinable()) return;
+        napi_remove_env_cleanup_hook(env, Cleanup, this);
+        Shutdown();
+    }
+
+private:
+    // Node is tearing the environment down, the connection may outlive it
+    static void Cleanup(void* arg) {
+        static_cast<IOThread*>(arg)->Shutdown();
+    }
+
+    void Shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        thread.join();
+        tsfn.Release();
+    }
+
+    void Loop() {
+        Napi::AsyncWorker* worker;
+        for (;;) {
+            if (requests.Pop(&worker)) {
+                worker->OnExecute(env);
+                completions.Push(worker);
+                if (!notified.exchange(true)) {
+                    tsfn.NonBlockingCall([this](Napi::Env env, Napi::Function) { Drain(env); });
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this]() { return stopping || !requests.Empty(); });
+            if (stopping && requests.Empty()) return;
+        }
+    }
+
+    // Settles every completed call; completing one may submit the next. The flag is cleared only once the
+    // queue is empty: a completion pushed meanwhile is either taken here or gets a wakeup of its own.
+    void Drain(Napi::Env env) {
+        Napi::AsyncWorker* worker;
+        do {
+            while (completions.Pop(&worker)) {
+                if (--inflight == 0) tsfn.Unref(env);
+                worker->OnWorkComplete(env, napi_ok);
+            }
+            notified.store(false);
+        } while (!completions.Empty() && !notified.exchange(true));
+    }
+
+    Napi::Env env;
+    SpscQueue<Napi::AsyncWorker*, 8> requests;
+    SpscQueue<Napi::AsyncWorker*, 8> completions;
+    std::atomic<bool> notified{false};
+    bool stopping = false;  // guarded by mutex
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    Napi::ThreadSafeFunction tsfn;
+    size_t inflight = 0;  // JS thread only
+    std::thread thread;
+};
+
+// A prepared statement kept by a StatementCache. VM objects handed out for it share it, so an
+// evicted statement stays usable until the last of them lets go.
+struct CachedStatement {
+    explicit CachedStatement(csqlvm* vm) : vm(vm) {}
+
+    // May run when the connection is gone, so the statement is only released locally
+    ~CachedStatement() {
+        cubesql_vmfree(vm);
+    }
+
+    csqlvm* vm;
+};
+
+// Prepared statements of a connection by normalized SQL, least recently used last (JS thread only).
+// The protocol addresses no statement, the server runs the one prepared last: the SDK prepares a
+// cached statement again on its next use when another one was prepared in between. A hit therefore
+// saves the round trip of the prepare only while the statement is still the one the server holds;
+// the SDK counts the statements it had to prepare again (cubesql_vm_reprepared).
+class StatementCache {
+public:
+    // Collapses whitespace outside of quotes and drops trailing semicolons, so formatting does not miss the cache
+    static std::string Normalize(const std::string& sql) {
+        std::string key;
+        key.reserve(sql.size());
+        char quote = 0;
+        for (char c : sql) {
+            if (quote) {
+                if (c == quote) quote = 0;
+            } else if (c == '\'' || c == '"' || c == '`') {
+                quote = c;
+            } else if (std::isspace(static_cast<unsigned char>(c))) {
+                if (!key.empty() && key.back() != ' ') key += ' ';
+                continue;
+            }
+            key += c;
+        }
+        while (!key.empty() && (key.back() == ' ' || key.back() == ';')) key.pop_back();
+        return key;
+    }
+
+    std::shared_ptr<CachedStatement> Find(const std::string& sql) {
+        if (capacity == 0) return nullptr;
+        auto found = index.find(Normalize(sql));
+        if (found == index.end()) {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        entries.splice(entries.begin(), entries, found->second);
+        return found->second->second;
+    }
+
+    // Takes ownership of a statement that was just prepared, which the server therefore holds
+    std::shared_ptr<CachedStatement> Insert(const std::string& sql, csqlvm* vm) {
+        std::shared_ptr<CachedStatement> statement = std::make_shared<CachedStatement>(vm);
+        if (capacity == 0) return statement;
+        std::string key = Normalize(sql);
+        auto found = index.find(key);
+        if (found != index.end()) {
+            Evict(found->second);
+        }
+        entries.emplace_front(key, statement);
+        index[key] = entries.begin();
+        while (entries.size() > capacity) Evict(std::prev(entries.end()));
+        return statement;
+    }
+
+    // Shrinking closes the least recently used statements; the connection must be idle
+    void SetCapacity(size_t size) {
+        capacity = size;
+        while (entries.size() > capacity) Evict(std::prev(entries.end()));
+    }
+
+    // Forgets every statement once the connection is closed
+    void Clear() {
+        index.clear();
+        entries.clear();
+    }
+
+    size_t Size() const {
+        return entries.size();
+    }
+
+    size_t capacity = 0;  // 0 disables the cache
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<CachedStatement>>;
+
+    // A statement no VM object uses any more is closed; it is not the one the server holds unless the
+    // cache shrinks, so the close is a local release in every other case
+    void Evict(std::list<Entry>::iterator entry) {
+        std::shared_ptr<CachedStatement>& statement = entry->second;
+        if (statement.use_count() == 1) {
+            cubesql_vmclose(statement->vm);
+            statement->vm = nullptr;
+        }
+        index.erase(entry->first);
+        entries.erase(entry);
+        evictions++;
+    }
+
+    std::list<Entry> entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+};
+
+// Per-connection state, shared by the Database object, its cursors and VMs and any async call in
+// flight, so the socket is closed only when the last of them lets go (or on an explicit disconnect).
+// It is also attached to csqldb through cubesql_setuserptr for the trace callback.
+// A connection serves one call at a time: while an async call owns the socket the
+// connection is busy and further async calls wait in pending (JS thread only).
+// An open server-side cursor or result stream owns the socket until it is finished or freed:
+// only the cursor itself and disconnect may use the connection meanwhile.
+struct Connection : std::enable_shared_from_this<Connection> {
+    explicit Connection(csqldb* db) : db(db) {
+        cubesql_setuserptr(db, this);
+    }
+
+    ~Connection() {
+        Close(kFALSE);
+        SetDedicatedThread(nullptr);
+    }
+
+    // Moves async calls to a thread of their own (or back to the threadpool with nullptr); only while idle
+    void SetDedicatedThread(std::unique_ptr<IOThread> thread) {
+        ioThread = std::move(thread);
+    }
+
+    void Close(int gracefully) {
+        if (!db) return;
+        if (ReleaseActiveCursor()) gracefully = kFALSE;
+        cubesql_disconnect(db, gracefully);
+        Detach();
+    }
+
+    // Cuts an open cursor loose from the connection, which is about to close:
+    // the cursor stops reading and is later freed without talking to the server
+    bool ReleaseActiveCursor() {
+        if (!activeCursor) return false;
+        cubesql_cursor_detach(activeCursor);
+        activeCursor = nullptr;
+        return true;
+    }
+
+    // Forgets the handle once cubesql_disconnect has released it
+    void Detach() {
+        db = nullptr;
+        statements.Clear();
+        if (hasTrace) {
+            traceFromWorker.Release();
+            trace.Reset();
+            hasTrace = false;
+        }
+    }
+
+    csqldb* db;
+    bool busy = false;
+    std::deque<ConnectionWorker*> pending;
+    std::thread::id jsThread = std::this_thread::get_id();
+    Napi::FunctionReference trace;
+    Napi::ThreadSafeFunction traceFromWorker;
+    bool hasTrace = false;
+    csqlc* activeCursor = nullptr;
+    bool inTransaction = false;  // a transaction begun through the API has not been committed or rolled back
+    std::unique_ptr<IOThread> ioThread;  // runs the async calls instead of the libuv threadpool when set
+    StatementCache statements;
+};
+
+static const char* kCursorActive = "Connection is reading a server-side cursor or result stream, finish or free it first";
+
+// Rows a server-side cursor requests ahead of the one being read, unless the select asks otherwise
+static const int kDefaultPrefetch = 64;
+
+static Connection* ConnectionOf(csqldb* db) {
+    return static_cast<Connection*>(cubesql_getuserptr(db));
+}
+
+// Sync calls must not touch a socket that an async call is using on a worker thread
+static bool EnsureIdle(Napi::Env env, csqldb* db) {
+    Connection* conn = ConnectionOf(db);
+    if (conn->busy) {
+        Napi::Error::New(env, "Connection is busy with an asynchronous operation").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (conn->activeCursor) {
+        Napi::Error::New(env, kCursorActive).ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+// Records the outcome of begin/commit/rollback, so a pool can roll back a transaction
+// left open on a connection that is handed back
+static int TrackTransaction(csqldb* db, int result, bool open) {
+    if (result == CUBESQL_NOERR) ConnectionOf(db)->inTransaction = open;
+    return result;
+}
+
+// Whether a failed call left the connection unusable: the SDK's own failures (negative codes and
+// its socket, protocol and TLS codes) as opposed to a statement error reported by the server,
+// which leaves the connection in sync.
+static bool ConnectionBroken(int errcode) {
+    return cubesql_isneterror(errcode) != 0;
+}
+
+// Every implementation takes its handle as first argument. When it is called as a method
+// (db.execute(sql)) the receiver takes that place, so one implementation serves both forms.
+class CallArgs {
+public:
+    CallArgs(const Napi::CallbackInfo& info, bool method) : info(info), method(method) {}
+
+    Napi::Env Env() const {
+        return info.Env();
+    }
+
+    size_t Length() const {
+        return info.Length() + (method ? 1 : 0);
+    }
+
+    Napi::Value operator[](size_t index) const {
+        if (!method) return info[index];
+        return (index == 0) ? info.This() : info[index - 1];
+    }
+
+private:
+    const Napi::CallbackInfo& info;
+    bool method;
+};
+
+template <auto Fn>
+static Napi::Value Invoke(const CallArgs& args) {
+    if constexpr (std::is_void_v<decltype(Fn(args))>) {
+        Fn(args);
+        return args.Env().Undefined();
+    } else {
+        return Fn(args);
+    }
+}
+
+template <auto Fn>
+static Napi::Value Export(const Napi::CallbackInfo& info) {
+    return Invoke<Fn>(CallArgs(info, false));
+}
+
+static const napi_type_tag kDatabaseTypeTag = { 0x2f6b0c3e9d8a4b71ULL, 0xa41c7e5b3d2f6e80ULL };
+static const napi_type_tag kCursorTypeTag = { 0x7d3a1f6c2b9e4d05ULL, 0xb85e2c4a1f7d3e92ULL };
+static const napi_type_tag kVMTypeTag = { 0x4c9e7b2a6d1f3e58ULL, 0x93d1a6f4c8b2e7a1ULL };
+static const napi_type_tag kStreamTypeTag = { 0x1e8d5c3b7a2f4960ULL, 0xc72b9e1d5a3f8e46ULL };
+static const napi_type_tag kPoolTypeTag = { 0x58a3e1f79c4d2b06ULL, 0xd16f4b8a2e9c7053ULL };
+
+// Constructors of the wrapped classes, stored as per-environment instance data
+struct AddonData {
+    Napi::FunctionReference database;
+    Napi::FunctionReference cursor;
+    Napi::FunctionReference vm;
+    Napi::FunctionReference stream;
+};
+
+// A connection returned by connectToCubeSQL / connectAsync
+class Database : public Napi::ObjectWrap<Database> {
+public:
+    Database(const Napi::CallbackInfo& info);
+    static Napi::Function Init(Napi::Env env, AddonData* data);
+    static Napi::Object NewInstance(Napi::Env env, csqldb* db);
+
+    template <auto Fn>
+    Napi::Value Method(const Napi::CallbackInfo& info) {
+        return Invoke<Fn>(CallArgs(info, true));
+    }
+
+    std::shared_ptr<Connection> conn;
+};
+
+// Owns a native cursor. It is shared by the Cursor object and by every zero-copy Buffer over the
+// cursor's memory, so the cursor is freed only after free() (or collection) and the last Buffer are gone.
+struct CursorData {
+    explicit CursorData(csqlc* cursor) : cursor(cursor) {}
+
+    ~CursorData() {
+        if (conn && conn->activeCursor == cursor) {
+            conn->activeCursor = nullptr;
+            // closing an open cursor talks to the server, which cannot happen while the socket is in use
+            if (conn->busy) cubesql_cursor_detach(cursor);
+        }
+        cubesql_cursor_free(cursor);
+    }
+
+    csqlc* cursor;
+    std::shared_ptr<Connection> conn;
+};
+
+// A result set; the native cursor is released by free() or when the object is collected
+class Cursor : public Napi::ObjectWrap<Cursor> {
+public:
+    Cursor(const Napi::CallbackInfo& info);
+    static Napi::Function Init(Napi::Env env, AddonData* data);
+    static Napi::Object NewInstance(Napi::Env env, csqlc* cursor, std::shared_ptr<Connection> conn);
+    void Free();
+
+    template <auto Fn>
+    Napi::Value Method(const Napi::CallbackInfo& info) {
+        return Invoke<Fn>(CallArgs(info, true));
+    }
+
+    std::shared_ptr<CursorData> data;
+};
+
+// A prepared statement; closed by close() or when the object is collected
+class VM : public Napi::ObjectWrap<VM> {
+public:
+    VM(const Napi::CallbackInfo& info);
+    ~VM();
+    static Napi::Function Init(Napi::Env env, AddonData* data);
+    static Napi::Object NewInstance(Napi::Env env, csqlvm* vm, std::shared_ptr<Connection> conn);
+    static Napi::Object NewInstance(Napi::Env env, std::shared_ptr<CachedStatement> statement, std::shared_ptr<Connection> conn);
+
+    template <auto Fn>
+    Napi::Value Method(const Napi::CallbackInfo& info) {
+        return Invoke<Fn>(CallArgs(info, true));
+    }
+
+    csqlvm* vm = nullptr;
+    std::shared_ptr<Connection> conn;
+    std::shared_ptr<CachedStatement> cached;  // set when the statement belongs to the connection's cache
+};
+
+// Rows of a select handed out chunk by chunk as the server sends them, as an async iterator.
+// The next chunk is acknowledged only when next() is called, so a slow consumer holds the server back.
+class ResultStream : public Napi::ObjectWrap<ResultStream> {
+public:
+    ResultStream(const Napi::CallbackInfo& info);
+    static Napi::Function Init(Napi::Env env, AddonData* data);
+    static Napi::Object NewInstance(Napi::Env env, std::shared_ptr<Connection> conn, std::string sql, bool asObjects);
+
+    template <auto Fn>
+    Napi::Value Method(const Napi::CallbackInfo& info) {
+        return Invoke<Fn>(CallArgs(info, true));
+    }
+
+    // Ends the stream, telling the server to stop if it was not read to the end
+    void Finish() {
+        done = true;
+        data.reset();
+    }
+
+    std::shared_ptr<Connection> conn;
+    std::string sql;
+    bool asObjects = false;
+    std::shared_ptr<CursorData> data;  // set once the first chunk has arrived
+    int delivered = 0;                 // chunks already handed out
+    bool reading = false;              // a next() is in flight
+    bool done = false;
+};
+
+static ResultStream* UnwrapStream(Napi::Env env, const Napi::Value& value) {
+    if (!value.IsObject() || !value.As<Napi::Object>().CheckTypeTag(&kStreamTypeTag)) {
+        Napi::TypeError::New(env, "Invalid result stream object").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    return ResultStream::Unwrap(value.As<Napi::Object>());
+}
+
+static Database* UnwrapDatabase(Napi::Env env, const Napi::Value& value) {
+    if (!value.IsObject() || !value.As<Napi::Object>().CheckTypeTag(&kDatabaseTypeTag)) {
+        Napi::TypeError::New(env, "Invalid database object").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    Database* database = Database::Unwrap(value.As<Napi::Object>());
+    if (!database->conn->db) {
+        Napi::Error::New(env, "Database connection is closed").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    return database;
+}
+
+static Cursor* UnwrapCursor(Napi::Env env, const Napi::Value& value) {
+    if (!value.IsObject() || !value.As<Napi::Object>().CheckTypeTag(&kCursorTypeTag)) {
+        Napi::TypeError::New(env, "Invalid cursor object").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    Cursor* cursor = Cursor::Unwrap(value.As<Napi::Object>());
+    if (!cursor->data) {
+        Napi::Error::New(env, "Cursor has been freed").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    return cursor;
+}
+
+static VM* UnwrapVM(Napi::Env env, const Napi::Value& value) {
+    if (!value.IsObject() || !value.As<Napi::Object>().CheckTypeTag(&kVMTypeTag)) {
+        Napi::TypeError::New(env, "Invalid VM object").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    VM* vm = VM::Unwrap(value.As<Napi::Object>());
+    if (!vm->vm) {
+        Napi::Error::New(env, "VM has been closed").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    if (!vm->conn->db) {
+        Napi::Error::New(env, "Database connection is closed").ThrowAsJavaScriptException();
+        return nullptr;
+    }
+    return vm;
+}
+
+static csqldb* GetDatabasePointer(Napi::Env env, const Napi::Value& value) {
+    Database* database = UnwrapDatabase(env, value);
+    return database ? database->conn->db : nullptr;
+}
+
+static csqlc* GetCursorPointer(Napi::Env env, const Napi::Value& value) {
+    Cursor* cursor = UnwrapCursor(env, value);
+    return cursor ? cursor->data->cursor : nullptr;
+}
+
+static csqlvm* GetVMPointer(Napi::Env env, const Napi::Value& value) {
+    VM* vm = UnwrapVM(env, value);
+    return vm ? vm->vm : nullptr;
+}
+
+// Base class for async calls on a connection. The promise settles on the JS thread:
+// rejections carry the SDK error message and the SDK error code as `code`.
+class ConnectionWorker : public Napi::AsyncWorker {
+public:
+    ConnectionWorker(Napi::Env env, csqldb* db)
+        : Napi::AsyncWorker(env), db(db), conn(ConnectionOf(db)->shared_from_this()), deferred(Napi::Promise::Deferred::New(env)) {}
+
+    // Runs now if the connection is idle, otherwise after the calls queued before it
+    Napi::Promise Start() {
+        Napi::Promise promise = deferred.Promise();
+        if (Blocked()) {
+            Abandon(kCursorActive);
+        } else if (conn->busy) {
+            conn->pending.push_back(this);
+        } else {
+            conn->busy = true;
+            Dispatch();
+        }
+        return promise;
+    }
+
+    // Keeps a handle object alive until the call completes, so its finalizer cannot
+    // release the native VM or cursor while a worker thread still uses it
+    ConnectionWorker* Retain(Napi::Value handle) {
+        owner = Napi::Persistent(handle.As<Napi::Object>());
+        return this;
+    }
+
+    // Rejects a call that never got to run and releases it
+    void Abandon(const char* message) {
+        Complete(CUBESQL_ERR);
+        if (!quiet) deferred.Reject(Napi::Error::New(Env(), message).Value());
+        delete this;
+    }
+
+    // Settles the given promise instead of the one returned by Start()
+    ConnectionWorker* Settles(Napi::Promise::Deferred target) {
+        deferred = target;
+        return this;
+    }
+
+    // Leaves the promise unsettled, for internal calls nobody waits on
+    ConnectionWorker* Quiet() {
+        quiet = true;
+        return this;
+    }
+
+    // Called on the JS thread once the connection is released, with the SDK error code of the call
+    ConnectionWorker* WhenDone(std::function<void(Napi::Env, int)> callback) {
+        done = std::move(callback);
+        return this;
+    }
+
+protected:
+    // Called on the worker thread; report failures through Fail()
+    virtual void Run() = 0;
+
+    // Called on the JS thread when the call gets the connection, right before it is queued
+    virtual void Prepare() {}
+
+    // Called on the JS thread to build the resolved value
+    virtual Napi::Value Result(Napi::Env env) {
+        return env.Undefined();
+    }
+
+    // Called on the JS thread before the promise is rejected with error
+    virtual void Failed(Napi::Object error) {}
+
+    // Whether the call belongs to the cursor holding the connection
+    virtual bool UsesCursor(csqlc* cursor) const {
+        return false;
+    }
+
+    void Fail() {
+        errcode = cubesql_errcode(db);
+        const char* errmsg = cubesql_errmsg(db);
+        SetError((errmsg && errmsg[0]) ? errmsg : "CubeSQL operation failed");
+    }
+
+    // Hands the connection to the next queued call, or marks it idle. Calls queued behind
+    // a call that left a cursor open cannot run until the cursor is finished or freed.
+    virtual void Release() {
+        while (!conn->pending.empty()) {
+            ConnectionWorker* next = conn->pending.front();
+            conn->pending.pop_front();
+            if (next->Blocked()) {
+                next->Abandon(kCursorActive);
+                continue;
+            }
+            next->Dispatch();
+            return;
+        }
+        conn->busy = false;
+    }
+
+    csqldb* db;
+    std::shared_ptr<Connection> conn;
+    bool closesConnection = false;
+
+private:
+    // Only the open cursor's own calls and disconnect may use a connection held by a cursor
+    bool Blocked() const {
+        return conn->activeCursor && !UsesCursor(conn->activeCursor) && !closesConnection;
+    }
+
+    void Dispatch() {
+        Prepare();
+        if (conn->ioThread) {
+            conn->ioThread->Submit(this);
+        } else {
+            Queue();
+        }
+    }
+
+    void Execute() override {
+        Run();
+    }
+
+    void Complete(int code) {
+        if (done) done(Env(), code);
+    }
+
+    void OnOK() override {
+        Napi::Value result = Result(Env());
+        Release();
+        Complete(CUBESQL_NOERR);
+        if (!quiet) deferred.Resolve(result);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        Napi::Object value = error.Value();
+        value.Set("code", Napi::Number::New(Env(), errcode));
+        Failed(value);
+        Release();
+        Complete(errcode);
+        if (!quiet) deferred.Reject(value);
+    }
+
+    Napi::Promise::Deferred deferred;
+    Napi::ObjectReference owner;
+    std::function<void(Napi::Env, int)> done;
+    bool quiet = false;
+    int errcode = CUBESQL_ERR;
+};
+
+// Resolves with undefined when the wrapped call returns CUBESQL_NOERR
+class StatusWorker : public ConnectionWorker {
+public:
+    StatusWorker(Napi::Env env, csqldb* db, std::function<int()> call)
+        : ConnectionWorker(env, db), call(std::move(call)) {}
+
+protected:
+    void Run() override {
+        if (call() != CUBESQL_NOERR) Fail();
+    }
+
+private:
+    std::function<int()> call;
+};
+
+// Resolves with the int64 returned by the wrapped call as a number
+class Int64Worker : public ConnectionWorker {
+public:
+    Int64Worker(Napi::Env env, csqldb* db, std::function<int64()> call)
+        : ConnectionWorker(env, db), call(std::move(call)) {}
+
+protected:
+    void Run() override {
+        cubesql_clear_errors(db);
+        value = call();
+        if (cubesql_errcode(db) != CUBESQL_NOERR) Fail();
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        return Napi::Number::New(env, static_cast<double>(value));
+    }
+
+private:
+    std::function<int64()> call;
+    int64 value = 0;
+};
+
+// { rc, changes, lastRowId } of executeEx
+static Napi::Object ExecuteExResult(Napi::Env env, int rc, int64 changes, int64 rowid) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("rc", Napi::Number::New(env, rc));
+    result.Set("changes", Napi::Number::New(env, static_cast<double>(changes)));
+    result.Set("lastRowId", Napi::Number::New(env, static_cast<double>(rowid)));
+    return result;
+}
+
+// Resolves with { rc, changes, lastRowId } like executeEx
+class ExecuteExWorker : public ConnectionWorker {
+public:
+    ExecuteExWorker(Napi::Env env, csqldb* db, std::string sql)
+        : ConnectionWorker(env, db), sql(std::move(sql)) {}
+
+protected:
+    void Run() override {
+        if (cubesql_execute_ex(db, sql.c_str(), &changes, &rowid) != CUBESQL_NOERR) Fail();
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        return ExecuteExResult(env, CUBESQL_NOERR, changes, rowid);
+    }
+
+private:
+    std::string sql;
+    int64 changes = 0;
+    int64 rowid = 0;
+};
+
+// The statements of db.pipeline and the outcome of each, written to the server back to back by
+// cubesql_execute_batch. Every statement runs even when one before it failed; with `transaction` they
+// run between BEGIN and COMMIT and a failure rolls all of them back. BEGIN gets a round trip of its
+// own, so no statement runs outside the transaction when it fails.
+struct Batch {
+    ~Batch() {
+        for (csqlc* cursor : cursors) cubesql_cursor_free(cursor);
+        for (char* message : errmsgs) free(message);
+    }
+
+    // Called on the thread that owns the connection; returns the error of the batch, if any,
+    // left on the connection before the transaction is finished
+    int Run(csqldb* db, std::function<void()> failed = nullptr) {
+        size_t offset = transaction ? 1 : 0;
+        size_t count = sql.size() + offset;
+        cursors.assign(count, nullptr);
+        errcodes.assign(count, CUBESQL_NOERR);
+        errmsgs.assign(count, nullptr);
+
+        // statements that never ran report the error of BEGIN
+        if (transaction && TrackTransaction(db, cubesql_begintransaction(db), true) != CUBESQL_NOERR) {
+            errcodes.assign(count, cubesql_errcode(db));
+            first = 0;
+            if (failed) failed();
+            return CUBESQL_ERR;
+        }
+
+        std::vector<const char*> text;
+        std::vector<int> isSelect;
+        for (size_t i = 0; i < sql.size(); i++) {
+            text.push_back(sql[i].c_str());
+            isSelect.push_back(select[i] ? kTRUE : kFALSE);
+        }
+        int result = cubesql_execute_batch(db, static_cast<int>(sql.size()), text.data(), isSelect.data(),
+                                           cursors.data() + offset, errcodes.data() + offset, errmsgs.data() + offset);
+        for (size_t i = 0; i < count && first < 0; i++) {
+            if (errcodes[i] != CUBESQL_NOERR) first = static_cast<int>(i);
+        }
+        if (result != CUBESQL_NOERR && failed) failed();
+        if (!transaction) return result;
+
+        // a COMMIT that failed on a live connection leaves the transaction open
+        if (result == CUBESQL_NOERR) {
+            result = TrackTransaction(db, cubesql_commit(db), false);
+            if (result == CUBESQL_NOERR) return result;
+            if (failed) failed();
+            if (!ConnectionBroken(cubesql_errcode(db))) TrackTransaction(db, cubesql_rollback(db), false);
+        } else if (!ConnectionBroken(errcodes[first])) {
+            TrackTransaction(db, cubesql_rollback(db), false);
+        }
+        return result;
+    }
+
+    // One { rc, message?, cursor? } per statement; cursors are handed over to Cursor objects
+    Napi::Array Results(Napi::Env env, std::shared_ptr<Connection> conn) {
+        size_t offset = transaction ? 1 : 0;
+        Napi::Array results = Napi::Array::New(env, sql.size());
+        for (size_t i = offset; i < cursors.size(); i++) {
+            Napi::Object result = Napi::Object::New(env);
+            result.Set("rc", Napi::Number::New(env, errcodes[i]));
+            if (errmsgs[i]) result.Set("message", Napi::String::New(env, errmsgs[i]));
+            if (cursors[i]) {
+                result.Set("cursor", Cursor::NewInstance(env, cursors[i], conn));
+                cursors[i] = nullptr;
+            }
+            results.Set(static_cast<uint32_t>(i - offset), result);
+        }
+        return results;
+    }
+
+    // Index of the first failed statement, -1 for BEGIN
+    int FailedStatement() const {
+        return transaction ? first - 1 : first;
+    }
+
+    std::vector<std::string> sql;
+    std::vector<bool> select;
+    bool transaction = false;
+    std::vector<csqlc*> cursors;
+    std::vector<int> errcodes;
+    std::vector<char*> errmsgs;
+    int first = -1;  // first failed request, including BEGIN
+};
+
+// Reads the statements of db.pipeline: sql strings to execute or { sql, select } objects,
+// and the options { transaction }
+static bool GetBatch(Napi::Env env, const CallArgs& info, Batch* batch) {
+    if (info.Length() < 2 || !info[1].IsArray()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), statements (array), options (object, optional)").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::Array statements = info[1].As<Napi::Array>();
+    for (uint32_t i = 0; i < statements.Length(); i++) {
+        Napi::Value statement = statements.Get(i);
+        if (statement.IsString()) {
+            batch->sql.push_back(statement.As<Napi::String>().Utf8Value());
+            batch->select.push_back(false);
+        } else if (statement.IsObject() && statement.As<Napi::Object>().Get("sql").IsString()) {
+            Napi::Object object = statement.As<Napi::Object>();
+            batch->sql.push_back(object.Get("sql").As<Napi::String>().Utf8Value());
+            batch->select.push_back(object.Get("select").ToBoolean().Value());
+        } else {
+            Napi::TypeError::New(env, "Statement " + std::to_string(i) + " must be a string or { sql, select }").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+
+    if (info.Length() > 2 && !info[2].IsUndefined()) {
+        if (!info[2].IsObject()) {
+            Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+            return false;
+        }
+        batch->transaction = info[2].As<Napi::Object>().Get("transaction").ToBoolean().Value();
+    }
+    return true;
+}
+
+// Resolves with the results of a pipelined batch. Failed statements are reported in the results;
+// the promise rejects only when the connection failed or a transaction was rolled back, with
+// `statement` set to the index of the first failed statement.
+class BatchWorker : public ConnectionWorker {
+public:
+    BatchWorker(Napi::Env env, csqldb* db, std::unique_ptr<Batch> batch)
+        : ConnectionWorker(env, db), batch(std::move(batch)) {}
+
+protected:
+    void Run() override {
+        // the error is taken while it is still on the connection, before the rollback
+        batch->Run(db, [this]() {
+            if (batch->transaction || ConnectionBroken(cubesql_errcode(db))) Fail();
+        });
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        return batch->Results(env, conn);
+    }
+
+    void Failed(Napi::Object error) override {
+        if (batch->first >= 0) error.Set("statement", Napi::Number::New(error.Env(), batch->FailedStatement()));
+    }
+
+private:
+    std::unique_ptr<Batch> batch;
+};
+
+// Resolves with a cursor object like the one returned by selectSQL
+class CursorWorker : public ConnectionWorker {
+public:
+    CursorWorker(Napi::Env env, csqldb* db, std::function<csqlc*()> call)
+        : ConnectionWorker(env, db), call(std::move(call)) {}
+
+protected:
+    void Run() override {
+        cursor = call();
+        if (!cursor) Fail();
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        return Cursor::NewInstance(env, cursor, conn);
+    }
+
+private:
+    std::function<csqlc*()> call;
+    csqlc* cursor = nullptr;
+};
+
+// Resolves with a VM object like the one returned by prepareVM
+class PrepareWorker : public ConnectionWorker {
+public:
+    PrepareWorker(Napi::Env env, csqldb* db, std::string sql)
+        : ConnectionWorker(env, db), sql(std::move(sql)) {}
+
+protected:
+    void Run() override {
+        vm = cubesql_vmprepare(db, sql.c_str());
+        if (!vm) Fail();
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        if (conn->statements.capacity > 0) {
+            return VM::NewInstance(env, conn->statements.Insert(sql, vm), conn);
+        }
+        return VM::NewInstance(env, vm, conn);
+    }
+
+private:
+    std::string sql;
+    csqlvm* vm = nullptr;
+};
+
+// Resolves with { data, isEndChunk } like receiveData, or null when nothing was received
+class ReceiveDataWorker : public ConnectionWorker {
+public:
+    ReceiveDataWorker(Napi::Env env, csqldb* db) : ConnectionWorker(env, db) {}
+
+protected:
+    void Run() override {
+        int len = 0;
+        char* buffer = cubesql_receive_data(db, &len, &isEndChunk);
+        if (buffer) data.assign(buffer, buffer + len);
+        received = (buffer != nullptr);
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        if (!received) return env.Null();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("data", Napi::Buffer<char>::Copy(env, data.data(), data.size()));
+        result.Set("isEndChunk", Napi::Boolean::New(env, isEndChunk));
+        return result;
+    }
+
+private:
+    std::vector<char> data;
+    int isEndChunk = 0;
+    bool received = false;
+};
+
+// Parameters of a bind, converted on the JS thread into storage the worker thread can read. Numbers and
+// BigInts are sent as text like the single bind calls do and strings are copied as UTF-8. Buffers and typed
+// arrays are not copied: the value points into their memory, which stays referenced until the call is done.
+// Rows are stored one after the other, Count() values each.
+struct BindParams {
+    int Count() const {
+        return nparams;
+    }
+
+    // Sizes the storage for rows of n parameters
+    void Reset(int n, int nrows) {
+        size_t total = static_cast<size_t>(n) * nrows;
+        nparams = n;
+        rows = nrows;
+        data.assign(total, std::string());
+        types.assign(total, CUBESQL_BIND_NULL);
+        lengths.assign(total, 0);
+        values.assign(total, nullptr);
+        errcodes.assign(n, CUBESQL_NOERR);
+    }
+
+    // Points the value array at the stored data, once the storage no longer moves
+    void Resolve() {
+        for (size_t i = 0; i < data.size(); i++) {
+            if (types[i] != CUBESQL_BIND_NULL && !values[i]) values[i] = &data[i][0];
+        }
+    }
+
+    // Binds the bytes of a Buffer, typed array or ArrayBuffer in place
+    void SetBytes(size_t slot, Napi::Object owner, void* bytes, size_t length) {
+        types[slot] = CUBESQL_BIND_BLOB;
+        values[slot] = static_cast<char*>(bytes);
+        lengths[slot] = static_cast<int>(length);
+        buffers.push_back(Napi::Persistent(owner));
+    }
+
+    int nparams = 0;
+    int rows = 1;
+    std::vector<std::string> data;
+    std::vector<int> types;
+    std::vector<int> lengths;
+    std::vector<char*> values;
+    std::vector<Napi::ObjectReference> buffers;  // keeps bound Buffers alive
+    std::vector<int> errcodes;  // result of every bind of the last row sent
+    int failed = -1;            // index of the first failed bind, Count() when the statement failed
+};
+
+// Names a parameter in error messages; row is -1 for a single row of parameters
+static std::string BindLabel(int row, int index) {
+    std::string label = "Parameter " + std::to_string(index + 1);
+    return (row < 0) ? label : "Row " + std::to_string(row) + ", parameter " + std::to_string(index + 1);
+}
+
+// Binds a Buffer, typed array or ArrayBuffer in place; the protocol sends lengths as 32-bit integers
+static bool SetBindBytes(Napi::Env env, BindParams* params, size_t slot, Napi::Object owner, void* bytes, size_t length, int row, int index) {
+    if (length > static_cast<size_t>(INT32_MAX)) {
+        Napi::RangeError::New(env, BindLabel(row, index) + " is larger than 2147483647 bytes").ThrowAsJavaScriptException();
+        return false;
+    }
+    params->SetBytes(slot, owner, bytes, length);
+    return true;
+}
+
+static void SetBindInteger(BindParams* params, size_t slot, long long n) {
+    char number[24];
+    char* end = std::to_chars(number, number + sizeof(number), n).ptr;
+    params->types[slot] = CUBESQL_BIND_INT64;
+    params->data[slot].assign(number, end - number);
+    params->lengths[slot] = static_cast<int>(end - number);
+}
+
+// Integral values within the exact range of a double are sent as integers, NaN as NULL;
+// Infinity has no value the server reads back as a number and is rejected
+static bool SetBindNumber(Napi::Env env, BindParams* params, size_t slot, double d, int row, int index) {
+    if (std::isnan(d)) return true;
+    if (std::isinf(d)) {
+        Napi::TypeError::New(env, BindLabel(row, index) + " must be a finite number or NaN").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (d == std::floor(d) && std::fabs(d) <= 9007199254740992.0) {
+        SetBindInteger(params, slot, static_cast<long long>(d));
+        return true;
+    }
+    char number[32];
+    int len = snprintf(number, sizeof(number), "%.17g", d);
+    params->types[slot] = CUBESQL_BIND_DOUBLE;
+    params->data[slot].assign(number, len);
+    params->lengths[slot] = len;
+    return true;
+}
+
+// Stores one parameter: number, bigint, boolean, string, Buffer, typed array, ArrayBuffer, null or undefined
+static bool SetBindValue(Napi::Env env, const Napi::Value& param, BindParams* params, size_t slot, int row, int index) {
+    std::string& text = params->data[slot];
+    int type;
+    if (param.IsNull() || param.IsUndefined()) {
+        return true;
+    } else if (param.IsBoolean()) {
+        type = CUBESQL_BIND_INTEGER;
+        text = param.As<Napi::Boolean>().Value() ? "1" : "0";
+    } else if (param.IsNumber()) {
+        return SetBindNumber(env, params, slot, param.As<Napi::Number>().DoubleValue(), row, index);
+    } else if (param.IsBigInt()) {
+        bool lossless = false;
+        int64_t n = param.As<Napi::BigInt>().Int64Value(&lossless);
+        if (!lossless) {
+            Napi::RangeError::New(env, BindLabel(row, index) + " does not fit into 64 bits").ThrowAsJavaScriptException();
+            return false;
+        }
+        SetBindInteger(params, slot, static_cast<long long>(n));
+        return true;
+    } else if (param.IsString()) {
+        type = CUBESQL_BIND_TEXT;
+        text = param.As<Napi::String>().Utf8Value();
+    } else if (param.IsTypedArray()) {
+        Napi::TypedArray array = param.As<Napi::TypedArray>();
+        uint8_t* bytes = static_cast<uint8_t*>(array.ArrayBuffer().Data()) + array.ByteOffset();
+        return SetBindBytes(env, params, slot, array, bytes, array.ByteLength(), row, index);
+    } else if (param.IsArrayBuffer()) {
+        Napi::ArrayBuffer buffer = param.As<Napi::ArrayBuffer>();
+        return SetBindBytes(env, params, slot, buffer, buffer.Data(), buffer.ByteLength(), row, index);
+    } else {
+        Napi::TypeError::New(env, BindLabel(row, index) + " must be a number, bigint, boolean, string, Buffer, typed array or null").ThrowAsJavaScriptException();
+        return false;
+    }
+    params->types[slot] = type;
+    params->lengths[slot] = static_cast<int>(text.size());
+    return true;
+}
+
+// Reads an array of parameters for indexes 1..n
+static bool GetBindParams(Napi::Env env, const Napi::Value& value, BindParams* params) {
+    if (!value.IsArray()) {
+        Napi::TypeError::New(env, "Expected argument: params (array)").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Array array = value.As<Napi::Array>();
+    int count = static_cast<int>(array.Length());
+    params->Reset(count, 1);
+    for (int i = 0; i < count; i++) {
+        if (!SetBindValue(env, array.Get(i), params, i, -1, i)) return false;
+    }
+    return true;
+}
+
+// Stores element i of a typed array column; float NaN is sent as NULL
+static bool SetBindElement(Napi::Env env, const Napi::TypedArray& column, size_t i, BindParams* params, size_t slot, int index) {
+    int row = static_cast<int>(i);
+    const uint8_t* base = static_cast<const uint8_t*>(column.ArrayBuffer().Data()) + column.ByteOffset();
+    switch (column.TypedArrayType()) {
+        case napi_int8_array: SetBindInteger(params, slot, reinterpret_cast<const int8_t*>(base)[i]); break;
+        case napi_uint8_array:
+        case napi_uint8_clamped_array: SetBindInteger(params, slot, base[i]); break;
+        case napi_int16_array: SetBindInteger(params, slot, reinterpret_cast<const int16_t*>(base)[i]); break;
+        case napi_uint16_array: SetBindInteger(params, slot, reinterpret_cast<const uint16_t*>(base)[i]); break;
+        case napi_int32_array: SetBindInteger(params, slot, reinterpret_cast<const int32_t*>(base)[i]); break;
+        case napi_uint32_array: SetBindInteger(params, slot, reinterpret_cast<const uint32_t*>(base)[i]); break;
+        case napi_float32_array: return SetBindNumber(env, params, slot, reinterpret_cast<const float*>(base)[i], row, index);
+        case napi_float64_array: return SetBindNumber(env, params, slot, reinterpret_cast<const double*>(base)[i], row, index);
+        case napi_bigint64_array: SetBindInteger(params, slot, reinterpret_cast<const int64_t*>(base)[i]); break;
+        default: {
+            // a BigUint64 value above INT64_MAX has no SQL integer to go to
+            uint64_t n = reinterpret_cast<const uint64_t*>(base)[i];
+            if (n <= static_cast<uint64_t>(INT64_MAX)) SetBindInteger(params, slot, static_cast<long long>(n));
+            else return SetBindNumber(env, params, slot, static_cast<double>(n), row, index);
+            break;
+        }
+    }
+    return true;
+}
+
+// Reads the rows of executeMany: an array of parameter arrays, or an object of columns in parameter order,
+// each an array or a typed array of the same length
+static bool GetBindRows(Napi::Env env, const Napi::Value& value, BindParams* params) {
+    if (value.IsArray()) {
+        Napi::Array rows = value.As<Napi::Array>();
+        uint32_t nrows = rows.Length();
+        int count = 0;
+        for (uint32_t row = 0; row < nrows; row++) {
+            Napi::Value item = rows.Get(row);
+            if (!item.IsArray()) {
+                Napi::TypeError::New(env, "Row " + std::to_string(row) + " must be an array of parameters").ThrowAsJavaScriptException();
+                return false;
+            }
+            Napi::Array array = item.As<Napi::Array>();
+            if (row == 0) {
+                count = static_cast<int>(array.Length());
+                if (count > 0 && nrows > static_cast<uint32_t>(INT32_MAX / count)) {
+                    Napi::RangeError::New(env, "Too many parameters").ThrowAsJavaScriptException();
+                    return false;
+                }
+                params->Reset(count, static_cast<int>(nrows));
+            } else if (array.Length() != static_cast<uint32_t>(count)) {
+                Napi::TypeError::New(env, "Row " + std::to_string(row) + " has " + std::to_string(array.Length()) + " parameters, expected " + std::to_string(count)).ThrowAsJavaScriptException();
+                return false;
+            }
+            size_t base = static_cast<size_t>(row) * count;
+            for (int i = 0; i < count; i++) {
+                if (!SetBindValue(env, array.Get(i), params, base + i, row, i)) return false;
+            }
+        }
+        if (nrows == 0) params->Reset(0, 0);
+        return true;
+    }
+
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: rows (array of arrays or object of columns)").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    Napi::Object columns = value.As<Napi::Object>();
+    Napi::Array names = columns.GetPropertyNames();
+    int count = static_cast<int>(names.Length());
+    std::vector<Napi::Value> values(count);
+    size_t nrows = 0;
+    for (int i = 0; i < count; i++) {
+        values[i] = columns.Get(names.Get(i));
+        size_t length;
+        if (values[i].IsTypedArray()) {
+            length = values[i].As<Napi::TypedArray>().ElementLength();
+        } else if (values[i].IsArray()) {
+            length = values[i].As<Napi::Array>().Length();
+        } else {
+            Napi::TypeError::New(env, "Column " + std::to_string(i + 1) + " must be an array or a typed array").ThrowAsJavaScriptException();
+            return false;
+        }
+        if (i == 0) {
+            nrows = length;
+        } else if (length != nrows) {
+            Napi::TypeError::New(env, "Column " + std::to_string(i + 1) + " has " + std::to_string(length) + " rows, expected " + std::to_string(nrows)).ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+    if (count > 0 && nrows > static_cast<size_t>(INT32_MAX / count)) {
+        Napi::RangeError::New(env, "Too many parameters").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    params->Reset(count, static_cast<int>(nrows));
+    for (int i = 0; i < count; i++) {
+        if (values[i].IsTypedArray()) {
+            Napi::TypedArray column = values[i].As<Napi::TypedArray>();
+            for (size_t row = 0; row < nrows; row++) {
+                if (!SetBindElement(env, column, row, params, row * count + i, i)) return false;
+            }
+        } else {
+            Napi::Array column = values[i].As<Napi::Array>();
+            for (size_t row = 0; row < nrows; row++) {
+                if (!SetBindValue(env, column.Get(static_cast<uint32_t>(row)), params, row * count + i, static_cast<int>(row), i)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Binds every parameter and executes (or selects) the VM with all requests pipelined, so the call waits for
+// the server once instead of once per parameter. A rejection caused by a bind carries `parameter`, the index
+// of the first parameter that failed, and `parameterErrors`, the error code of every bind. The server runs
+// the statement even when a bind failed, with that parameter left at its previous value.
+class BindExecuteWorker : public ConnectionWorker {
+public:
+    BindExecuteWorker(Napi::Env env, csqlvm* vm, BindParams params, bool select)
+        : ConnectionWorker(env, cubesql_vm_db(vm)), vm(vm), params(std::move(params)), select(select) {}
+
+protected:
+    void Run() override {
+        BindParams& p = params;
+        p.Resolve();
+        if (select) {
+            cursor = cubesql_vmbind_select(vm, p.Count(), p.types.data(), p.values.data(), p.lengths.data(), p.errcodes.data(), &p.failed);
+            if (!cursor) Fail();
+        } else if (cubesql_vmbind_execute(vm, p.Count(), p.types.data(), p.values.data(), p.lengths.data(), p.errcodes.data(), &p.failed) != CUBESQL_NOERR) {
+            Fail();
+        }
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        return select ? Cursor::NewInstance(env, cursor, conn) : env.Undefined();
+    }
+
+    void Failed(Napi::Object error) override {
+        if (params.failed < 0 || params.failed >= params.Count()) return;
+        Napi::Env env = error.Env();
+        Napi::Array errors = Napi::Array::New(env, params.errcodes.size());
+        for (uint32_t i = 0; i < params.errcodes.size(); i++) {
+            errors.Set(i, Napi::Number::New(env, params.errcodes[i]));
+        }
+        error.Set("parameter", Napi::Number::New(env, params.failed + 1));
+        error.Set("parameterErrors", errors);
+    }
+
+private:
+    csqlvm* vm;
+    BindParams params;
+    bool select;
+    csqlc* cursor = nullptr;
+};
+
+// Runs one statement once per row of parameters without returning to JS in between: the given VM, or
+// the SQL prepared once for the call and closed afterwards (or kept in the connection's statement cache).
+// Each row pipelines its binds, the execute and the changes() query. With `transaction` the rows run
+// between BEGIN and COMMIT and the first failure rolls all of them back. The first failed row stops the
+// loop; the rejection carries `row` and, when a bind failed, `parameter`.
+class ExecuteManyWorker : public ConnectionWorker {
+public:
+    ExecuteManyWorker(Napi::Env env, csqldb* db, csqlvm* vm, std::string sql, BindParams params, bool transaction, bool changes)
+        : ConnectionWorker(env, db), vm(vm), sql(std::move(sql)), params(std::move(params)), transaction(transaction), changes(changes) {}
+
+    // Runs a statement of the connection's cache, or keeps the one prepared for the call in the cache
+    ExecuteManyWorker* Cached(std::shared_ptr<CachedStatement> statement) {
+        cached = std::move(statement);
+        if (cached) vm = cached->vm;
+        keep = !cached && conn->statements.capacity > 0;
+        return this;
+    }
+
+protected:
+    void Run() override {
+        BindParams& p = params;
+        p.Resolve();
+        if (transaction && TrackTransaction(db, cubesql_begintransaction(db), true) != CUBESQL_NOERR) {
+            Fail();
+            return;
+        }
+
+        int result = CUBESQL_ERR;
+        csqlvm* statement = vm ? vm : cubesql_vmprepare(db, sql.c_str());
+        if (statement) {
+            if (changes) counts.assign(p.rows, 0);
+            result = cubesql_vmexecute_many(statement, p.rows, p.Count(), p.types.data(), p.values.data(), p.lengths.data(), changes ? counts.data() : nullptr, &failedRow, &failedParam);
+        }
+        // the error is kept before the cleanup below overwrites it
+        if (result != CUBESQL_NOERR) Fail();
+        if (statement && !vm) {
+            if (keep) prepared = statement;
+            else cubesql_vmclose(statement);
+        }
+
+        if (!transaction) return;
+        if (result != CUBESQL_NOERR) {
+            TrackTransaction(db, cubesql_rollback(db), false);
+        } else if (TrackTransaction(db, cubesql_commit(db), false) != CUBESQL_NOERR) {
+            Fail();
+            if (!ConnectionBroken(cubesql_errcode(db))) TrackTransaction(db, cubesql_rollback(db), false);
+        }
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        Keep();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("rows", Napi::Number::New(env, params.rows));
+        if (changes) {
+            Napi::Array array = Napi::Array::New(env, counts.size());
+            for (uint32_t i = 0; i < counts.size(); i++) {
+                array.Set(i, Napi::Number::New(env, static_cast<double>(counts[i])));
+            }
+            result.Set("changes", array);
+        }
+        return result;
+    }
+
+    void Failed(Napi::Object error) override {
+        Keep();
+        Napi::Env env = error.Env();
+        if (failedRow >= 0) error.Set("row", Napi::Number::New(env, failedRow));
+        if (failedParam >= 0 && failedParam < params.Count()) error.Set("parameter", Napi::Number::New(env, failedParam + 1));
+    }
+
+private:
+    csqlvm* vm;
+    std::string sql;
+    BindParams params;
+    bool transaction;
+    bool changes;
+    std::vector<int64> counts;
+    int failedRow = -1;
+    int failedParam = -1;
+    std::shared_ptr<CachedStatement> cached;
+    bool keep = false;
+    csqlvm* prepared = nullptr;
+
+    void Keep() {
+        if (prepared) conn->statements.Insert(sql, prepared);
+        prepared = nullptr;
+    }
+};
+
+// Closes the connection once every call queued before it has completed;
+// calls queued after it are rejected
+class DisconnectWorker : public ConnectionWorker {
+public:
+    DisconnectWorker(Napi::Env env, csqldb* db) : ConnectionWorker(env, db) {
+        closesConnection = true;
+    }
+
+protected:
+    void Run() override {
+        cubesql_disconnect(db, gracefully);
+    }
+
+    // Runs on the JS thread just before the worker is queued
+    void Prepare() override {
+        if (conn->ReleaseActiveCursor()) gracefully = kFALSE;
+    }
+
+    void Release() override {
+        conn->Detach();
+        while (!conn->pending.empty()) {
+            ConnectionWorker* next = conn->pending.front();
+            conn->pending.pop_front();
+            next->Abandon("Connection closed");
+        }
+        conn->busy = false;
+    }
+
+private:
+    int gracefully = kTRUE;
+};
+
+// Opens a connection on a worker thread: name resolution, TCP connect, TLS setup and
+// authentication all happen off the event loop, so several connects can run in parallel
+class ConnectWorker : public Napi::AsyncWorker {
+public:
+    ConnectWorker(Napi::Env env, std::string host, int port, std::string username, std::string password,
+                  int timeout, int encryption, bool ssl, std::string sslCertificatePath)
+        : Napi::AsyncWorker(env), host(std::move(host)), port(port), username(std::move(username)),
+          password(std::move(password)), timeout(timeout), encryption(encryption),
+          ssl(ssl), sslCertificatePath(std::move(sslCertificatePath)), deferred(Napi::Promise::Deferred::New(env)) {}
+
+    // Called on the JS thread with the Database object, or with the error and ok set to false
+    using Callback = std::function<void(Napi::Env env, Napi::Value result, bool ok)>;
+
+    Napi::Promise Start() {
+        Napi::Promise promise = deferred.Promise();
+        Queue();
+        return promise;
+    }
+
+    // Reports to the callback instead of settling a promise
+    void Start(Callback callback) {
+        completion = std::move(callback);
+        Queue();
+    }
+
+    // Selects the database right after connecting, in the same worker call
+    ConnectWorker* UseDatabase(std::string name) {
+        database = std::move(name);
+        return this;
+    }
+
+private:
+    void Execute() override {
+        int result;
+        if (ssl) {
+            result = cubesql_connect_ssl(&db, host.c_str(), port, username.c_str(), password.c_str(), timeout, sslCertificatePath.c_str());
+        } else {
+            result = cubesql_connect(&db, host.c_str(), port, username.c_str(), password.c_str(), timeout, encryption);
+        }
+        if (result == CUBESQL_NOERR && db && !database.empty()) result = cubesql_set_database(db, database.c_str());
+        if (result == CUBESQL_NOERR && db) return;
+
+        errcode = result;
+        std::string message = "Failed to connect to CubeSQL server";
+        if (db) {
+            const char* errmsg = cubesql_errmsg(db);
+            if (errmsg && errmsg[0]) message = errmsg;
+            if (cubesql_errcode(db) != CUBESQL_NOERR) errcode = cubesql_errcode(db);
+            cubesql_disconnect(db, kFALSE);
+            db = nullptr;
+        }
+        SetError(message);
+    }
+
+    void OnOK() override {
+        Napi::Object database = Database::NewInstance(Env(), db);
+        if (completion) completion(Env(), database, true);
+        else deferred.Resolve(database);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        Napi::Object value = error.Value();
+        value.Set("code", Napi::Number::New(Env(), errcode));
+        if (completion) completion(Env(), value, false);
+        else deferred.Reject(value);
+    }
+
+    std::string host;
+    int port;
+    std::string username;
+    std::string password;
+    int timeout;
+    int encryption;
+    bool ssl;
+    std::string sslCertificatePath;
+    std::string database;
+    csqldb* db = nullptr;
+    int errcode = CUBESQL_ERR;
+    Napi::Promise::Deferred deferred;
+    Callback completion;
+};
+
 // Wrapper for cubesql_version
-Napi::String GetCubeSQLVersion(const Napi::CallbackInfo& info) {
+Napi::String GetCubeSQLVersion(const CallArgs& info) {
+    Napi::Env env = info.Env();
+    return Napi::String::New(env, cubesql_version());
+}
+
+// Wrapper for cubesql_connect
+Napi::Value ConnectToCubeSQL(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 6 || !info[0].IsString() || !info[1].IsNumber() ||
+        !info[2].IsString() || !info[3].IsString() || !info[4].IsNumber() || !info[5].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: host (string), port (number), username (string), password (string), timeout (number), encryption (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string host = info[0].As<Napi::String>();
+    int port = info[1].As<Napi::Number>();
+    std::string username = info[2].As<Napi::String>();
+    std::string password = info[3].As<Napi::String>();
+    int timeout = info[4].As<Napi::Number>();
+    int encryption = info[5].As<Napi::Number>();
+
+    csqldb* db = nullptr;
+    int result = cubesql_connect(&db, host.c_str(), port, username.c_str(), password.c_str(), timeout, encryption);
+
+    if (result != CUBESQL_NOERR || db == nullptr) {
+        if (db) cubesql_disconnect(db, kFALSE);
+        Napi::Error::New(env, "Failed to connect to CubeSQL server").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return Database::NewInstance(env, db);
+}
+
+// Wrapper for cubesql_disconnect
+void DisconnectFromCubeSQL(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return;
+    }
+
+    // Disconnecting twice is harmless
+    if (!info[0].As<Napi::Object>().CheckTypeTag(&kDatabaseTypeTag)) {
+        Napi::TypeError::New(env, "Invalid database object").ThrowAsJavaScriptException();
+        return;
+    }
+    std::shared_ptr<Connection> conn = Database::Unwrap(info[0].As<Napi::Object>())->conn;
+    if (!conn->db) {
+        return;
+    }
+    if (conn->busy) {
+        Napi::Error::New(env, "Connection is busy with an asynchronous operation").ThrowAsJavaScriptException();
+        return;
+    }
+    // An open cursor is cut loose and the connection closed without the goodbye
+    conn->Close(kTRUE);
+}
+
+// Implementation for ConnectToCubeSQLSSL
+Napi::Value ConnectToCubeSQLSSL(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 7 || !info[0].IsString() || !info[1].IsNumber() ||
+        !info[2].IsString() || !info[3].IsString() || !info[4].IsNumber() ||
+        !info[5].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: host (string), port (number), username (string), password (string), timeout (number), ssl_certificate_path (string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string host = info[0].As<Napi::String>();
+    int port = info[1].As<Napi::Number>();
+    std::string username = info[2].As<Napi::String>();
+    std::string password = info[3].As<Napi::String>();
+    int timeout = info[4].As<Napi::Number>();
+    std::string ssl_certificate_path = info[5].As<Napi::String>();
+
+    csqldb* db = nullptr;
+    int result = cubesql_connect_ssl(&db, host.c_str(), port, username.c_str(), password.c_str(), timeout, ssl_certificate_path.c_str());
+
+    if (result != CUBESQL_NOERR) {
+        if (db) cubesql_disconnect(db, kFALSE);
+        return Napi::Number::New(env, result);
+    }
+
+    return Database::NewInstance(env, db);
+}
+
+// Implementation for ExecuteSQL
+Napi::Value ExecuteSQL(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    std::string sql = info[1].As<Napi::String>();
+
+    int result = cubesql_execute(db, sql.c_str());
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for ExecuteEx
+// Executes sql and reads SHOW CHANGES and SHOW LASTROWID in the same round trip
+Napi::Value ExecuteEx(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    std::string sql = info[1].As<Napi::String>();
+
+    int64 changes, rowid;
+    int result = cubesql_execute_ex(db, sql.c_str(), &changes, &rowid);
+    return ExecuteExResult(env, result, changes, rowid);
+}
+
+// Implementation for Pipeline
+// Sends every statement before reading the first reply and returns one { rc, message?, cursor? } per statement
+Napi::Value Pipeline(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), statements (array), options (object, optional)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    Batch batch;
+    if (!GetBatch(env, info, &batch)) {
+        return env.Null();
+    }
+    if (batch.transaction && ConnectionOf(db)->inTransaction) {
+        Napi::Error::New(env, "A transaction is already open on this connection").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    batch.Run(db);
+    return batch.Results(env, ConnectionOf(db)->shared_from_this());
+}
+
+// Reads a result compression mode: 'on', 'off', 'auto' or a boolean
+static bool GetCompressionMode(Napi::Env env, const Napi::Value& value, int* mode) {
+    if (value.IsBoolean()) {
+        *mode = value.As<Napi::Boolean>().Value() ? CUBESQL_COMPRESSION_ON : CUBESQL_COMPRESSION_OFF;
+        return true;
+    }
+    std::string name = value.IsString() ? value.As<Napi::String>().Utf8Value() : std::string();
+    if (name == "on") *mode = CUBESQL_COMPRESSION_ON;
+    else if (name == "off") *mode = CUBESQL_COMPRESSION_OFF;
+    else if (name == "auto") *mode = CUBESQL_COMPRESSION_AUTO;
+    else {
+        Napi::TypeError::New(env, "compression must be 'on', 'off', 'auto' or a boolean").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+// Runs a select with the result compression mode of the query, CUBESQL_COMPRESSION_DEFAULT keeps the connection's
+static csqlc* SelectWithCompression(csqldb* db, const std::string& sql, int serverSide, int compression) {
+    cubesql_set_query_compression(db, compression);
+    csqlc* cursor = cubesql_select(db, sql.c_str(), serverSide);
+    cubesql_set_query_compression(db, CUBESQL_COMPRESSION_DEFAULT);
+    return cursor;
+}
+
+// Reads the optional select options: { serverSide, prefetch, compression }. A server-side cursor keeps its rows
+// on the server and steps through them with prefetch requests in flight (capped by the SDK). compression overrides the result
+// compression of the connection for the select.
+static bool GetSelectOptions(Napi::Env env, const CallArgs& info, size_t index, int* serverSide, int* prefetch, int* compression) {
+    *serverSide = kFALSE;
+    *prefetch = kDefaultPrefetch;
+    *compression = CUBESQL_COMPRESSION_DEFAULT;
+    if (info.Length() <= index || info[index].IsUndefined()) return true;
+    if (!info[index].IsObject()) {
+        Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::Object options = info[index].As<Napi::Object>();
+    Napi::Value value = options.Get("serverSide");
+    if (!value.IsUndefined()) *serverSide = value.ToBoolean().Value() ? kTRUE : kFALSE;
+    value = options.Get("prefetch");
+    if (!value.IsUndefined()) {
+        if (!value.IsNumber() || value.As<Napi::Number>().Int32Value() < 1) {
+            Napi::TypeError::New(env, "prefetch must be a positive number").ThrowAsJavaScriptException();
+            return false;
+        }
+        *prefetch = value.As<Napi::Number>().Int32Value();
+    }
+    value = options.Get("compression");
+    if (!value.IsUndefined() && !GetCompressionMode(env, value, compression)) return false;
+    return true;
+}
+
+// Reads { transaction, changes } for executeMany
+static bool GetExecuteManyOptions(Napi::Env env, const CallArgs& info, size_t index, bool* transaction, bool* changes) {
+    *transaction = false;
+    *changes = true;
+    if (info.Length() <= index || info[index].IsUndefined()) return true;
+    if (!info[index].IsObject()) {
+        Napi::TypeError::New(env, "options must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::Object options = info[index].As<Napi::Object>();
+    Napi::Value value = options.Get("transaction");
+    if (!value.IsUndefined()) *transaction = value.ToBoolean().Value();
+    value = options.Get("changes");
+    if (!value.IsUndefined()) *changes = value.ToBoolean().Value();
+    return true;
+}
+
+// Implementation for SelectSQL
+Napi::Value SelectSQL(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string), options (object, optional)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    std::string sql = info[1].As<Napi::String>();
+    int serverSide, prefetch, compression;
+    if (!GetSelectOptions(env, info, 2, &serverSide, &prefetch, &compression)) {
+        return env.Null();
+    }
+
+    csqlc* cursor = SelectWithCompression(db, sql, serverSide, compression);
+    if (!cursor) {
+        return env.Null();
+    }
+    cubesql_cursor_setprefetch(cursor, prefetch);
+
+    return Cursor::NewInstance(env, cursor, ConnectionOf(db)->shared_from_this());
+}
+
+// Implementation for CommitTransaction
+Napi::Value CommitTransaction(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    int result = TrackTransaction(db, cubesql_commit(db), false);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for RollbackTransaction
+Napi::Value RollbackTransaction(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    int result = TrackTransaction(db, cubesql_rollback(db), false);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for BeginTransaction
+Napi::Value BeginTransaction(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    int result = TrackTransaction(db, cubesql_begintransaction(db), true);
+    return Napi::Number::New(env, result);
+}
+
+// Reads the values of bindSQL: (values) with the type of every value taken from the value itself, or the
+// (colvalue, colsize, coltype, ncols) arrays, where a blob value may also be a Buffer or typed array.
+// cubesql_bind sends text values with their terminating 0, which std::string provides.
+static bool GetBindSQLParams(Napi::Env env, const CallArgs& info, BindParams* params) {
+    if (info.Length() < 4 || info[3].IsUndefined()) {
+        if (info.Length() < 3 || !info[2].IsArray()) {
+            Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string), values (array)").ThrowAsJavaScriptException();
+            return false;
+        }
+        return GetBindParams(env, info[2], params);
+    }
+
+    if (info.Length() < 6 || !info[2].IsArray() || !info[3].IsArray() || !info[4].IsArray() || !info[5].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string), colvalue (array), colsize (array), coltype (array), ncols (number)").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::Array colvalueArray = info[2].As<Napi::Array>();
+    Napi::Array colsizeArray = info[3].As<Napi::Array>();
+    Napi::Array coltypeArray = info[4].As<Napi::Array>();
+    int ncols = info[5].As<Napi::Number>();
+
+    params->Reset(ncols, 1);
+    for (int i = 0; i < ncols; i++) {
+        Napi::Value value = colvalueArray.Get(i);
+        int size = colsizeArray.Get(i).As<Napi::Number>();
+        int type = coltypeArray.Get(i).As<Napi::Number>();
+        if (type == CUBESQL_BIND_BLOB && value.IsTypedArray()) {
+            Napi::TypedArray array = value.As<Napi::TypedArray>();
+            uint8_t* bytes = static_cast<uint8_t*>(array.ArrayBuffer().Data()) + array.ByteOffset();
+            if (!SetBindBytes(env, params, i, array, bytes, std::min(static_cast<size_t>(size), array.ByteLength()), -1, i)) return false;
+            continue;
+        }
+        params->data[i] = value.ToString().Utf8Value();
+        params->types[i] = type;
+        params->lengths[i] = size;
+    }
+    return true;
+}
+
+// Implementation for BindSQL
+Napi::Value BindSQL(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string), values (array)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    std::string sql = info[1].As<Napi::String>();
+    BindParams params;
+    if (!GetBindSQLParams(env, info, &params)) {
+        return env.Null();
+    }
+    params.Resolve();
+
+    int result = cubesql_bind(db, sql.c_str(), params.values.data(), params.lengths.data(), params.types.data(), params.Count());
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for PingCubeSQL
+Napi::Value PingCubeSQL(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    int result = cubesql_ping(db);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for CancelCubeSQL
+void CancelCubeSQL(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return;
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return;
+    }
+    cubesql_cancel(db);
+}
+
+// Implementation for GetErrorCode
+Napi::Value GetErrorCode(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    int result = cubesql_errcode(db);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for GetErrorMessage
+Napi::Value GetErrorMessage(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    char* errmsg = cubesql_errmsg(db);
+    return Napi::String::New(env, errmsg);
+}
+
+// Implementation for GetChanges
+Napi::Value GetChanges(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    int64_t changes = cubesql_changes(db);
+    return Napi::Number::New(env, static_cast<double>(changes));
+}
+
+// Implementation for SetTraceCallback
+void SetTraceCallback(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), callback (function)").ThrowAsJavaScriptException();
+        return;
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return;
+    }
+    // A call running on another thread may be inside traceFromWorker right now
+    if (!EnsureIdle(env, db)) {
+        return;
+    }
+    Connection* conn = ConnectionOf(db);
+    if (conn->hasTrace) {
+        conn->traceFromWorker.Release();
+    }
+
+    // The SDK invokes the trace callback on whichever thread runs the statement,
+    // so calls made from async workers are marshalled back to the JS thread
+    Napi::Function callback = info[1].As<Napi::Function>();
+    conn->trace = Napi::Persistent(callback);
+    conn->traceFromWorker = Napi::ThreadSafeFunction::New(env, callback, "cubesql_trace", 0, 1);
+    conn->traceFromWorker.Unref(env);
+    conn->hasTrace = true;
+
+    auto traceCallback = [](const char* message, void* data) {
+        Connection* conn = static_cast<Connection*>(data);
+        if (std::this_thread::get_id() == conn->jsThread) {
+            conn->trace.Call({Napi::String::New(conn->trace.Env(), message)});
+            return;
+        }
+        std::string* copy = new std::string(message);
+        napi_status status = conn->traceFromWorker.BlockingCall(copy, [](Napi::Env env, Napi::Function fn, std::string* msg) {
+            fn.Call({Napi::String::New(env, *msg)});
+            delete msg;
+        });
+        if (status != napi_ok) {
+            delete copy;
+        }
+    };
+    cubesql_set_trace_callback(db, traceCallback, conn);
+}
+
+// Implementation for SetDedicatedThread
+void SetDedicatedThread(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsBoolean()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), enabled (boolean)").ThrowAsJavaScriptException();
+        return;
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return;
+    }
+    Connection* conn = ConnectionOf(db);
+    if (conn->busy) {
+        Napi::Error::New(env, "Connection is busy with an asynchronous operation").ThrowAsJavaScriptException();
+        return;
+    }
+    bool enabled = info[1].As<Napi::Boolean>();
+    if (enabled == (conn->ioThread != nullptr)) return;
+    conn->SetDedicatedThread(enabled ? std::make_unique<IOThread>(env) : nullptr);
+}
+
+// Implementation for SetStatementCache
+void SetStatementCache(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber() || info[1].As<Napi::Number>().DoubleValue() < 0) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), capacity (non-negative number)").ThrowAsJavaScriptException();
+        return;
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return;
+    }
+    // shrinking may close the statement the server holds
+    if (!EnsureIdle(env, db)) {
+        return;
+    }
+    ConnectionOf(db)->statements.SetCapacity(static_cast<size_t>(info[1].As<Napi::Number>().DoubleValue()));
+}
+
+// Implementation for GetStatementCacheStats
+Napi::Value GetStatementCacheStats(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    const StatementCache& cache = ConnectionOf(db)->statements;
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("capacity", Napi::Number::New(env, static_cast<double>(cache.capacity)));
+    stats.Set("size", Napi::Number::New(env, static_cast<double>(cache.Size())));
+    stats.Set("hits", Napi::Number::New(env, static_cast<double>(cache.hits)));
+    stats.Set("misses", Napi::Number::New(env, static_cast<double>(cache.misses)));
+    stats.Set("evictions", Napi::Number::New(env, static_cast<double>(cache.evictions)));
+    stats.Set("reprepares", Napi::Number::New(env, static_cast<double>(cubesql_vm_reprepared(db))));
+    return stats;
+}
+
+// Compression policy of a connection for the packets it sends, see cubesql_set_compression
+struct CompressionOptions {
+    int level = -1;          // zlib level, -1 the zlib default and 0 no compression
+    int minSize = 512;       // packets below this many bytes are sent uncompressed
+    bool statements = false; // also compress the SQL of large statements
+};
+
+// Reads { level, minSize, statements }, any of them may be left out
+static bool GetCompressionOptions(Napi::Env env, const Napi::Value& value, CompressionOptions* options) {
+    if (!value.IsObject()) {
+        Napi::TypeError::New(env, "Compression options must be an object").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::Object object = value.As<Napi::Object>();
+
+    Napi::Value level = object.Get("level");
+    if (!level.IsUndefined()) {
+        if (!level.IsNumber() || level.As<Napi::Number>().DoubleValue() < -1 || level.As<Napi::Number>().DoubleValue() > 9) {
+            Napi::RangeError::New(env, "Compression level must be between -1 and 9").ThrowAsJavaScriptException();
+            return false;
+        }
+        options->level = level.As<Napi::Number>().Int32Value();
+    }
+    Napi::Value minSize = object.Get("minSize");
+    if (!minSize.IsUndefined()) {
+        if (!minSize.IsNumber() || minSize.As<Napi::Number>().DoubleValue() < 0) {
+            Napi::TypeError::New(env, "Compression minSize must be a non-negative number").ThrowAsJavaScriptException();
+            return false;
+        }
+        options->minSize = static_cast<int>(std::min(minSize.As<Napi::Number>().DoubleValue(), 2147483647.0));
+    }
+    Napi::Value statements = object.Get("statements");
+    if (!statements.IsUndefined()) {
+        if (!statements.IsBoolean()) {
+            Napi::TypeError::New(env, "Compression statements must be a boolean").ThrowAsJavaScriptException();
+            return false;
+        }
+        options->statements = statements.As<Napi::Boolean>().Value();
+    }
+    return true;
+}
+
+// Implementation for SetCompression
+void SetCompression(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), options (object)").ThrowAsJavaScriptException();
+        return;
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return;
+    }
+    CompressionOptions options;
+    if (!GetCompressionOptions(env, info[1], &options)) {
+        return;
+    }
+    // the policy is read by the worker sending the packets
+    if (!EnsureIdle(env, db)) {
+        return;
+    }
+    cubesql_set_compression(db, options.level, options.minSize, options.statements ? kTRUE : kFALSE);
+}
+
+// Implementation for SetResultCompression
+void SetResultCompression(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), mode ('on', 'off' or 'auto')").ThrowAsJavaScriptException();
+        return;
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return;
+    }
+    int mode;
+    if (!GetCompressionMode(env, info[1], &mode)) {
+        return;
+    }
+    if (!EnsureIdle(env, db)) {
+        return;
+    }
+    cubesql_set_result_compression(db, mode);
+}
+
+// Implementation for GetCompressionStats
+Napi::Value GetCompressionStats(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    int64 bytesIn = 0, bytesOut = 0, skipped = 0;
+    cubesql_compression_stats(db, &bytesIn, &bytesOut, &skipped);
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("bytesIn", Napi::Number::New(env, static_cast<double>(bytesIn)));
+    stats.Set("bytesOut", Napi::Number::New(env, static_cast<double>(bytesOut)));
+    stats.Set("skipped", Napi::Number::New(env, static_cast<double>(skipped)));
+
+    // replies received, times in milliseconds
+    csqlresultstats replies;
+    cubesql_result_stats(db, &replies);
+    Napi::Object results = Napi::Object::New(env);
+    results.Set("compressed", Napi::Number::New(env, static_cast<double>(replies.compressed)));
+    results.Set("uncompressed", Napi::Number::New(env, static_cast<double>(replies.uncompressed)));
+    results.Set("bytesCompressed", Napi::Number::New(env, static_cast<double>(replies.bytescompressed)));
+    results.Set("bytesExpanded", Napi::Number::New(env, static_cast<double>(replies.bytesexpanded)));
+    results.Set("bytesUncompressed", Napi::Number::New(env, static_cast<double>(replies.bytesuncompressed)));
+    results.Set("inflateTime", Napi::Number::New(env, replies.inflateusec / 1000.0));
+    results.Set("inflateTimeSaved", Napi::Number::New(env, replies.savedusec / 1000.0));
+    results.Set("bandwidth", Napi::Number::New(env, static_cast<double>(replies.bandwidth)));
+    results.Set("rtt", Napi::Number::New(env, replies.rttusec / 1000.0));
+    results.Set("advertising", Napi::Boolean::New(env, replies.advertising != kFALSE));
+    stats.Set("results", results);
+    return stats;
+}
+
+// Implementation for SetDatabase
+Napi::Value SetDatabase(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), dbname (string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    std::string dbname = info[1].As<Napi::String>();
+
+    int result = cubesql_set_database(db, dbname.c_str());
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for GetAffectedRows
+Napi::Value GetAffectedRows(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    int64_t affectedRows = cubesql_affected_rows(db);
+    return Napi::Number::New(env, static_cast<double>(affectedRows));
+}
+
+// Implementation for GetLastInsertedRowID
+Napi::Value GetLastInsertedRowID(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    int64_t lastRowID = cubesql_last_inserted_rowID(db);
+    return Napi::Number::New(env, static_cast<double>(lastRowID));
+}
+
+// Implementation for SleepMilliseconds
+void SleepMilliseconds(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected argument: milliseconds (number)").ThrowAsJavaScriptException();
+        return;
+    }
+
+    int milliseconds = info[0].As<Napi::Number>();
+    cubesql_mssleep(milliseconds);
+}
+
+// Implementation for SendData
+Napi::Value SendData(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsBuffer() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), buffer (Buffer), length (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    Napi::Buffer<char> buffer = info[1].As<Napi::Buffer<char>>();
+    int length = info[2].As<Napi::Number>();
+
+    int result = cubesql_send_data(db, buffer.Data(), length);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for SendEndData
+Napi::Value SendEndData(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    int result = cubesql_send_enddata(db);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for ReceiveData
+Napi::Value ReceiveData(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    int len = 0;
+    int is_end_chunk = 0;
+    char* data = cubesql_receive_data(db, &len, &is_end_chunk);
+
+    if (!data) {
+        return env.Null();
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("data", Napi::Buffer<char>::Copy(env, data, len));
+    result.Set("isEndChunk", Napi::Boolean::New(env, is_end_chunk));
+
+    return result;
+}
+
+// Implementation for PrepareVM
+Napi::Value PrepareVM(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, db)) {
+        return env.Null();
+    }
+    std::string sql = info[1].As<Napi::String>();
+    Connection* conn = ConnectionOf(db);
+    std::shared_ptr<CachedStatement> statement = conn->statements.Find(sql);
+    if (statement) {
+        return VM::NewInstance(env, statement, conn->shared_from_this());
+    }
+
+    csqlvm* vm = cubesql_vmprepare(db, sql.c_str());
+    if (!vm) {
+        return env.Null();
+    }
+    if (conn->statements.capacity > 0) {
+        return VM::NewInstance(env, conn->statements.Insert(sql, vm), conn->shared_from_this());
+    }
+
+    return VM::NewInstance(env, vm, conn->shared_from_this());
+}
+
+// Implementation for BindVMInt
+Napi::Value BindVMInt(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number), intValue (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, cubesql_vm_db(vm))) {
+        return env.Null();
+    }
+    int index = info[1].As<Napi::Number>();
+    int intValue = info[2].As<Napi::Number>();
+
+    int result = cubesql_vmbind_int(vm, index, intValue);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for BindVMDouble
+Napi::Value BindVMDouble(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number), doubleValue (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, cubesql_vm_db(vm))) {
+        return env.Null();
+    }
+    int index = info[1].As<Napi::Number>();
+    double doubleValue = info[2].As<Napi::Number>();
+
+    int result = cubesql_vmbind_double(vm, index, doubleValue);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for BindVMText
+Napi::Value BindVMText(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number), textValue (string)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, cubesql_vm_db(vm))) {
+        return env.Null();
+    }
+    int index = info[1].As<Napi::Number>();
+    std::string textValue = info[2].As<Napi::String>();
+
+    int result = cubesql_vmbind_text(vm, index, const_cast<char*>(textValue.c_str()), textValue.length());
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for BindVM
+// Binds a number, bigint, boolean, string, Buffer, typed array or null with the type taken from the value
+Napi::Value BindVM(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number), value").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, cubesql_vm_db(vm))) {
+        return env.Null();
+    }
+    int index = info[1].As<Napi::Number>();
+    BindParams params;
+    params.Reset(1, 1);
+    if (!SetBindValue(env, info[2], &params, 0, -1, index - 1)) {
+        return env.Null();
+    }
+    params.Resolve();
+
+    int result = cubesql_vmbind_value(vm, index, params.types[0], params.values[0], params.lengths[0]);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for BindVMNull
+Napi::Value BindVMNull(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, cubesql_vm_db(vm))) {
+        return env.Null();
+    }
+    int index = info[1].As<Napi::Number>();
+
+    int result = cubesql_vmbind_null(vm, index);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for BindVMInt64
+Napi::Value BindVMInt64(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number), int64Value (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, cubesql_vm_db(vm))) {
+        return env.Null();
+    }
+    int index = info[1].As<Napi::Number>();
+    int64_t int64Value = info[2].As<Napi::Number>().Int64Value();
+
+    int result = cubesql_vmbind_int64(vm, index, int64Value);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for BindVMZeroBlob
+Napi::Value BindVMZeroBlob(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number), length (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, cubesql_vm_db(vm))) {
+        return env.Null();
+    }
+    int index = info[1].As<Napi::Number>();
+    int length = info[2].As<Napi::Number>();
+
+    int result = cubesql_vmbind_zeroblob(vm, index, length);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for ExecuteVM
+Napi::Value ExecuteVM(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: vmObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, cubesql_vm_db(vm))) {
+        return env.Null();
+    }
+    int result = cubesql_vmexecute(vm);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for SelectVM
+Napi::Value SelectVM(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: vmObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
+        return env.Null();
+    }
+    if (!EnsureIdle(env, cubesql_vm_db(vm))) {
+        return env.Null();
+    }
+
+    csqlc* cursor = cubesql_vmselect(vm);
+    if (!cursor) {
+        return env.Null();
+    }
+
+    return Cursor::NewInstance(env, cursor, ConnectionOf(cubesql_vm_db(vm))->shared_from_this());
+}
+
+// Implementation for CloseVM
+Napi::Value CloseVM(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: vmObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    VM* handle = UnwrapVM(env, info[0]);
+    if (!handle) {
+        return env.Null();
+    }
+    if (handle->cached) {
+        // the statement stays in the cache
+        handle->vm = nullptr;
+        handle->cached.reset();
+        return Napi::Number::New(env, CUBESQL_NOERR);
+    }
+    if (!EnsureIdle(env, handle->conn->db)) {
+        return env.Null();
+    }
+    int result = cubesql_vmclose(handle->vm);
+    handle->vm = nullptr;
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for GetCursorNumRows
+Napi::Value GetCursorNumRows(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: cursorObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int result = cubesql_cursor_numrows(cursor);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for GetCursorNumColumns
+Napi::Value GetCursorNumColumns(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: cursorObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int result = cubesql_cursor_numcolumns(cursor);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for GetCursorCurrentRow
+Napi::Value GetCursorCurrentRow(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: cursorObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int result = cubesql_cursor_currentrow(cursor);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for SeekCursor
+Napi::Value SeekCursor(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), index (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int index = info[1].As<Napi::Number>();
+
+    int result = cubesql_cursor_seek(cursor, index);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for IsCursorEOF
+Napi::Value IsCursorEOF(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: cursorObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int result = cubesql_cursor_iseof(cursor);
+    return Napi::Boolean::New(env, result);
+}
+
+// Implementation for GetCursorColumnType
+Napi::Value GetCursorColumnType(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), index (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int index = info[1].As<Napi::Number>();
+
+    int result = cubesql_cursor_columntype(cursor, index);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for GetCursorField
+Napi::Value GetCursorField(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int row = info[1].As<Napi::Number>();
+    int column = info[2].As<Napi::Number>();
+
+    int len = 0;
+    char* field = cubesql_cursor_field(cursor, row, column, &len);
+
+    if (!field) {
+        return env.Null();
+    }
+
+    return Napi::String::New(env, std::string(field, len));
+}
+
+// Returns a Buffer over a field of the cursor without copying it. The Buffer holds a reference
+// on the cursor, so the memory stays valid after free() until the Buffer itself is collected.
+// Server-side cursors reuse their row buffer on every step and streams release each chunk once
+// the next one is requested, so their fields are copied.
+static Napi::Value FieldBuffer(Napi::Env env, const std::shared_ptr<CursorData>& data, char* field, int len) {
+    if (cubesql_cursor_isserverside(data->cursor) || cubesql_cursor_isstream(data->cursor)) {
+        return Napi::Buffer<char>::Copy(env, field, static_cast<size_t>(len));
+    }
+    auto* hint = new std::shared_ptr<CursorData>(data);
+    return Napi::Buffer<char>::NewOrCopy(env, field, static_cast<size_t>(len),
+        [](Napi::Env, char*, std::shared_ptr<CursorData>* hint) { delete hint; }, hint);
+}
+
+Napi::Value GetCursorFieldBuffer(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Cursor* handle = UnwrapCursor(env, info[0]);
+    if (!handle) {
+        return env.Null();
+    }
+    int row = info[1].As<Napi::Number>();
+    int column = info[2].As<Napi::Number>();
+
+    int len = 0;
+    char* field = cubesql_cursor_field(handle->data->cursor, row, column, &len);
+
+    if (!field || len < 0) {
+        return env.Null();
+    }
+
+    // Return binary data as Napi::Buffer (instead of a string)
+    return FieldBuffer(env, handle->data, field, len);
+}
+
+// Implementation for GetCursorRowID
+Napi::Value GetCursorRowID(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int row = info[1].As<Napi::Number>();
+
+    int64_t rowID = cubesql_cursor_rowid(cursor, row);
+    return Napi::Number::New(env, static_cast<double>(rowID));
+}
+
+// Implementation for GetCursorInt64
+Napi::Value GetCursorInt64(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 4 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number), defaultValue (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int row = info[1].As<Napi::Number>();
+    int column = info[2].As<Napi::Number>();
+    int64_t defaultValue = info[3].As<Napi::Number>().Int64Value();
+
+    int64_t result = cubesql_cursor_int64(cursor, row, column, defaultValue);
+    return Napi::Number::New(env, static_cast<double>(result));
+}
+
+// Implementation for GetCursorInt
+Napi::Value GetCursorInt(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 4 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number), defaultValue (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int row = info[1].As<Napi::Number>();
+    int column = info[2].As<Napi::Number>();
+    int defaultValue = info[3].As<Napi::Number>();
+
+    int result = cubesql_cursor_int(cursor, row, column, defaultValue);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for GetCursorDouble
+Napi::Value GetCursorDouble(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 4 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number), defaultValue (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int row = info[1].As<Napi::Number>();
+    int column = info[2].As<Napi::Number>();
+    double defaultValue = info[3].As<Napi::Number>();
+
+    double result = cubesql_cursor_double(cursor, row, column, defaultValue);
+    return Napi::Number::New(env, result);
+}
+
+// Implementation for GetCursorCString
+Napi::Value GetCursorCString(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int row = info[1].As<Napi::Number>();
+    int column = info[2].As<Napi::Number>();
+
+    char* result = cubesql_cursor_cstring(cursor, row, column);
+    if (!result) {
+        return env.Null();
+    }
+
+    return Napi::String::New(env, result);
+}
+
+// Implementation for GetCursorCStringStatic
+Napi::Value GetCursorCStringStatic(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 4 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsBuffer()) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number), staticBuffer (Buffer)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+    int row = info[1].As<Napi::Number>();
+    int column = info[2].As<Napi::Number>();
+    Napi::Buffer<char> staticBuffer = info[3].As<Napi::Buffer<char>>();
+
+    char* result = cubesql_cursor_cstring_static(cursor, row, column, staticBuffer.Data(), staticBuffer.Length());
+    if (!result) {
+        return env.Null();
+    }
+
+    return Napi::String::New(env, result);
+}
+
+// Implementation for FreeCursor
+void FreeCursor(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: cursorObject (object)").ThrowAsJavaScriptException();
+        return;
+    }
+
+    Cursor* handle = UnwrapCursor(env, info[0]);
+    if (!handle) {
+        return;
+    }
+    handle->Free();
+}
+
+// Builds the JS value of a single field: a string, or null for NULL fields
+static inline Napi::Value FieldValue(Napi::Env env, const char* field, int len) {
+    if (!field || len < 0) return env.Null();
+    return Napi::String::New(env, field, static_cast<size_t>(len));
+}
+
+// Reads the optional shape option: 'arrays' (the default) or 'objects'
+static bool GetShapeOption(Napi::Env env, const CallArgs& info, size_t index, bool* asObjects) {
+    *asObjects = false;
+    if (info.Length() <= index || !info[index].IsObject()) return true;
+    Napi::Value shape = info[index].As<Napi::Object>().Get("shape");
+    if (shape.IsUndefined()) return true;
+    std::string value = shape.IsString() ? shape.As<Napi::String>().Utf8Value() : std::string();
+    if (value != "arrays" && value != "objects") {
+        Napi::TypeError::New(env, "shape must be 'arrays' or 'objects'").ThrowAsJavaScriptException();
+        return false;
+    }
+    *asObjects = (value == "objects");
+    return true;
+}
+
+// Turns cursor rows into JS rows for fetchAll and result streams. Rows are arrays of fields
+// or objects keyed by column name; NULL fields become null and Blob fields Buffers.
+class RowBuilder {
+public:
+    RowBuilder(Napi::Env env, std::shared_ptr<CursorData> data, bool asObjects)
+        : env(env), data(std::move(data)), asObjects(asObjects) {
+        csqlc* cursor = this->data->cursor;
+        ncols = cubesql_cursor_numcolumns(cursor);
+        blob.resize(ncols);
+        for (int col = 0; col < ncols; col++) {
+            blob[col] = (cubesql_cursor_columntype(cursor, col + 1) == CUBESQL_Type_Blob);
+        }
+
+        // Column names are created once and shared by every row object, so all rows get the same shape
+        if (!asObjects) return;
+        descriptors.resize(ncols);
+        for (int col = 0; col < ncols; col++) {
+            int len = 0;
+            char* name = cubesql_cursor_field(cursor, CUBESQL_COLNAME, col + 1, &len);
+            napi_property_descriptor& descriptor = descriptors[col];
+            descriptor = napi_property_descriptor();
+            descriptor.name = Napi::String::New(env, name ? name : "", name ? static_cast<size_t>(len) : 0);
+            descriptor.attributes = static_cast<napi_property_attributes>(napi_writable | napi_enumerable | napi_configurable);
+        }
+    }
+
+    // Sets rows[index] to the row whose fields are returned by field(col, &len)
+    template <typename Field>
+    void Append(Napi::Array rows, uint32_t index, Field&& field) {
+        Napi::HandleScope scope(env);
+        Napi::Object row;
+        if (asObjects) {
+            row = Napi::Object::New(env);
+            for (int col = 0; col < ncols; col++) {
+                int len = 0;
+                char* value = field(col, &len);
+                descriptors[col].value = Value(col, value, len);
+            }
+            napi_status status = napi_define_properties(env, row, descriptors.size(), descriptors.data());
+            NAPI_THROW_IF_FAILED_VOID(env, status);
+        } else {
+            Napi::Array array = Napi::Array::New(env, ncols);
+            for (int col = 0; col < ncols; col++) {
+                int len = 0;
+                char* value = field(col, &len);
+                array.Set(static_cast<uint32_t>(col), Value(col, value, len));
+            }
+            row = array;
+        }
+        rows.Set(index, row);
+    }
+
+    // Appends the rows of a received chunk at rows[index...], at most limit rows; returns the count.
+    // The chunk is walked directly: field n starts at data + sum[n-1].
+    uint32_t AppendChunk(Napi::Array rows, uint32_t index, int chunk, uint32_t limit) {
+        char* chunkData = nullptr;
+        int* size = nullptr;
+        int* sum = nullptr;
+        int cnum = 0;
+        int chunkRows = cubesql_cursor_chunk(data->cursor, chunk, &chunkData, &size, &sum, &cnum);
+        int first = cnum - ncols;
+        uint32_t count = 0;
+        for (int r = 0; r < chunkRows && count < limit; r++, count++) {
+            int base = r * cnum + first;
+            Append(rows, index + count, [&](int col, int* len) -> char* {
+                int n = base + col;
+                *len = size[n];
+                if (size[n] == -1) return nullptr;
+                return (n > 0) ? chunkData + sum[n - 1] : chunkData;
+            });
+        }
+        return count;
+    }
+
+private:
+    Napi::Value Value(int col, char* field, int len) {
+        if (blob[col] && field && len >= 0) return FieldBuffer(env, data, field, len);
+        return FieldValue(env, field, len);
+    }
+
+    Napi::Env env;
+    std::shared_ptr<CursorData> data;
+    bool asObjects;
+    int ncols = 0;
+    std::vector<bool> blob;
+    std::vector<napi_property_descriptor> descriptors;
+};
+
+// Implementation for FetchAll
+// Materializes every row of a cursor in one call. Rows are arrays of fields ('arrays', the default)
+// or objects keyed by column name ('objects'); NULL fields become null and Blob fields zero-copy Buffers.
+// Server-side cursors are rejected: every row would cost a round trip on the JS thread.
+Napi::Value FetchAll(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject() || (info.Length() > 1 && !info[1].IsUndefined() && !info[1].IsObject())) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), options (object, optional)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Cursor* handle = UnwrapCursor(env, info[0]);
+    if (!handle) {
+        return env.Null();
+    }
+    csqlc* cursor = handle->data->cursor;
+
+    bool asObjects;
+    if (!GetShapeOption(env, info, 1, &asObjects)) {
+        return env.Null();
+    }
+
+    if (cubesql_cursor_isserverside(cursor)) {
+        Napi::Error::New(env, "fetchAll is not supported on server side cursors, read them with seekCursor or use selectStream").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int nrows = cubesql_cursor_numrows(cursor);
+    if (nrows < 0) nrows = 0;
+    Napi::Array rows = Napi::Array::New(env, nrows);
+    RowBuilder builder(env, handle->data, asObjects);
+
+
+    int nchunks = cubesql_cursor_numchunks(cursor);
+    if (nchunks == 0) {
+        // Custom cursors keep no contiguous buffers: go through the per-field accessor
+        for (int r = 0; r < nrows; r++) {
+            builder.Append(rows, static_cast<uint32_t>(r), [&](int col, int* len) -> char* {
+                return cubesql_cursor_field(cursor, r + 1, col + 1, len);
+            });
+        }
+        return rows;
+    }
+
+    uint32_t index = 0;
+    for (int chunk = 0; chunk < nchunks; chunk++) {
+        index += builder.AppendChunk(rows, index, chunk, static_cast<uint32_t>(nrows) - index);
+    }
+
+    return rows;
+}
+
+// Implementation for FetchColumns
+// Extracts numeric columns into typed arrays: Integer columns become BigInt64Array, Boolean columns
+// Int32Array and Float/Currency columns Float64Array. Each entry also has a nulls bitmap
+// (Uint8Array, bit i set when row i is NULL).
+Napi::Value FetchColumns(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsArray()) {
+        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), columns (array)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqlc* cursor = GetCursorPointer(env, info[0]);
+    if (!cursor) {
+        return env.Null();
+    }
+
+    int nrows = cubesql_cursor_numrows(cursor);
+    if (nrows < 0) {
+        Napi::Error::New(env, "fetchColumns is not supported on server side cursors").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array columns = info[1].As<Napi::Array>();
+    uint32_t ncolumns = columns.Length();
+    int ncols = cubesql_cursor_numcolumns(cursor);
+    Napi::Array result = Napi::Array::New(env, ncolumns);
+
+    for (uint32_t i = 0; i < ncolumns; i++) {
+        Napi::Value value = columns.Get(i);
+        int column = value.IsNumber() ? value.As<Napi::Number>().Int32Value() : 0;
+        if (column <= 0 || column > ncols) {
+            Napi::RangeError::New(env, "Invalid column index").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+
+        Napi::Uint8Array nulls = Napi::Uint8Array::New(env, (static_cast<size_t>(nrows) + 7) / 8);
+        Napi::Value values;
+        int type = cubesql_cursor_columntype(cursor, column);
+        switch (type) {
+            case CUBESQL_Type_Integer: {
+                Napi::BigInt64Array array = Napi::BigInt64Array::New(env, nrows);
+                cubesql_cursor_column_int64(cursor, column, reinterpret_cast<int64*>(array.Data()), nulls.Data());
+                values = array;
+                break;
+            }
+            case CUBESQL_Type_Boolean: {
+                Napi::Int32Array array = Napi::Int32Array::New(env, nrows);
+                cubesql_cursor_column_int(cursor, column, array.Data(), nulls.Data());
+                values = array;
+                break;
+            }
+            case CUBESQL_Type_Float:
+            case CUBESQL_Type_Currency: {
+                Napi::Float64Array array = Napi::Float64Array::New(env, nrows);
+                cubesql_cursor_column_double(cursor, column, array.Data(), nulls.Data());
+                values = array;
+                break;
+            }
+            default:
+                Napi::TypeError::New(env, "Column " + std::to_string(column) + " is not a numeric column").ThrowAsJavaScriptException();
+                return env.Null();
+        }
+
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("values", values);
+        entry.Set("nulls", nulls);
+        result.Set(i, entry);
+    }
+
+    return result;
+}
+
+// Builds the { value, done } result of a result stream from the chunks received since the last call
+static Napi::Value StreamResult(Napi::Env env, ResultStream* stream) {
+    Napi::Object result = Napi::Object::New(env);
+    if (stream->done) {
+        result.Set("value", env.Undefined());
+        result.Set("done", Napi::Boolean::New(env, true));
+        return result;
+    }
+
+    csqlc* cursor = stream->data->cursor;
+    bool pending = cubesql_cursor_stream_pending(cursor);
+    stream->conn->activeCursor = pending ? cursor : nullptr;
+
+    int nchunks = cubesql_cursor_numchunks(cursor);
+    if (stream->delivered >= nchunks) {
+        stream->Finish();
+        return StreamResult(env, stream);
+    }
+
+    Napi::Array rows = Napi::Array::New(env);
+    RowBuilder builder(env, stream->data, stream->asObjects);
+    uint32_t count = 0;
+    for (; stream->delivered < nchunks; stream->delivered++) {
+        count += builder.AppendChunk(rows, count, stream->delivered, UINT32_MAX);
+    }
+    // Rows are copied out of the chunks, so the last one can be released right away
+    if (!pending) stream->Finish();
+
+    result.Set("value", rows);
+    result.Set("done", Napi::Boolean::New(env, false));
+    return result;
+}
+
+// Reads the first chunk of a result stream, or acknowledges the last chunk and reads the next one.
+// When closing, tells the server to stop sending chunks instead.
+class StreamWorker : public ConnectionWorker {
+public:
+    StreamWorker(Napi::Env env, ResultStream* stream, bool closing)
+        : ConnectionWorker(env, stream->conn->db), stream(stream), closing(closing) {}
+
+protected:
+    void Run() override {
+        if (stream->done) return;
+        csqlc* cursor = stream->data ? stream->data->cursor : nullptr;
+        if (closing) {
+            if (cursor) cubesql_cursor_stream_abort(cursor);
+        } else if (!cursor) {
+            opened = cubesql_select_stream(db, stream->sql.c_str());
+            if (!opened) Fail();
+        } else if (cubesql_cursor_stream_next(cursor) != CUBESQL_NOERR) {
+            Fail();
+        }
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        if (opened) {
+            stream->data = std::make_shared<CursorData>(opened);
+            stream->data->conn = conn;
+        }
+        if (closing) stream->Finish();
+        return StreamResult(env, stream);
+    }
+
+    // A failed read leaves the chunk exchange out of step, so the stream cannot continue
+    void Failed(Napi::Object error) override {
+        stream->Finish();
+    }
+
+    bool UsesCursor(csqlc* cursor) const override {
+        return stream->data && stream->data->cursor == cursor;
+    }
+
+private:
+    ResultStream* stream;
+    bool closing;
+    csqlc* opened = nullptr;
+};
+
+// Implementation for SelectStream
+// Returns a result stream right away; the select is sent by its first next() call
+Napi::Value SelectStream(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString() || (info.Length() > 2 && !info[2].IsUndefined() && !info[2].IsObject())) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string), options (object, optional)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    csqldb* db = GetDatabasePointer(env, info[0]);
+    if (!db) {
+        return env.Null();
+    }
+    std::string sql = info[1].As<Napi::String>();
+    bool asObjects;
+    if (!GetShapeOption(env, info, 2, &asObjects)) {
+        return env.Null();
+    }
+
+    return ResultStream::NewInstance(env, ConnectionOf(db)->shared_from_this(), std::move(sql), asObjects);
+}
+
+// Implementation for StreamNext
+// Resolves with { value: rows, done: false } for each received chunk and { done: true } at the end.
+// Calls are queued on the connection, so several pending next() calls resolve in order.
+Napi::Value StreamNext(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    ResultStream* stream = UnwrapStream(env, info[0]);
+    if (!stream) {
+        return env.Null();
+    }
+    if (stream->done) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(StreamResult(env, stream));
+        return deferred.Promise();
+    }
+    if (!stream->conn->db) {
+        Napi::Error::New(env, "Database connection is closed").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return (new StreamWorker(env, stream, false))->Retain(info[0])->Start();
+}
+
+// Implementation for StreamReturn
+// Ends the stream early (for await ... break); the server is told to stop sending chunks
+Napi::Value StreamReturn(const CallArgs& info) {
     Napi::Env env = info.Env();
-    return Napi::String::New(env, cubesql_version());
+
+    ResultStream* stream = UnwrapStream(env, info[0]);
+    if (!stream) {
+        return env.Null();
+    }
+    if (stream->done || !stream->conn->db) {
+        stream->Finish();
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(StreamResult(env, stream));
+        return deferred.Promise();
+    }
+    return (new StreamWorker(env, stream, true))->Retain(info[0])->Start();
 }
 
-// Wrapper for cubesql_connect
-Napi::Value ConnectToCubeSQL(const Napi::CallbackInfo& info) {
+// Implementation for StreamIterator
+Napi::Value StreamIterator(const CallArgs& info) {
+    return info[0];
+}
+
+// Implementation for ConnectAsync
+Napi::Value ConnectAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 6 || !info[0].IsString() || !info[1].IsNumber() ||
@@ -24,42 +3372,14 @@ Napi::Value ConnectToCubeSQL(const Napi::CallbackInfo& info) {
     int timeout = info[4].As<Napi::Number>();
     int encryption = info[5].As<Napi::Number>();
 
-    csqldb* db = nullptr;
-    int result = cubesql_connect(&db, host.c_str(), port, username.c_str(), password.c_str(), timeout, encryption);
-
-    if (result != CUBESQL_NOERR || db == nullptr) {
-        Napi::Error::New(env, "Failed to connect to CubeSQL server").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-
-    Napi::Object dbObject = Napi::Object::New(env);
-    dbObject.Set("dbPointer", Napi::External<csqldb>::New(env, db));
-    return dbObject;
-}
-
-// Wrapper for cubesql_disconnect
-void DisconnectFromCubeSQL(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
-        return;
-    }
-
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
-    if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
-        return;
-    }
-    cubesql_disconnect(db, kTRUE);
+    return (new ConnectWorker(env, host, port, username, password, timeout, encryption, false, ""))->Start();
 }
 
-// Implementation for ConnectToCubeSQLSSL
-Napi::Value ConnectToCubeSQLSSL(const Napi::CallbackInfo& info) {
+// Implementation for ConnectSSLAsync
+Napi::Value ConnectSSLAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 7 || !info[0].IsString() || !info[1].IsNumber() ||
+    if (info.Length() < 6 || !info[0].IsString() || !info[1].IsNumber() ||
         !info[2].IsString() || !info[3].IsString() || !info[4].IsNumber() ||
         !info[5].IsString()) {
         Napi::TypeError::New(env, "Expected arguments: host (string), port (number), username (string), password (string), timeout (number), ssl_certificate_path (string)").ThrowAsJavaScriptException();
@@ -73,22 +3393,11 @@ Napi::Value ConnectToCubeSQLSSL(const Napi::CallbackInfo& info) {
     int timeout = info[4].As<Napi::Number>();
     std::string ssl_certificate_path = info[5].As<Napi::String>();
 
-    csqldb* db = nullptr;
-    int result = cubesql_connect_ssl(&db, host.c_str(), port, username.c_str(), password.c_str(), timeout, ssl_certificate_path.c_str());
-
-    if (result != CUBESQL_NOERR) {
-        return Napi::Number::New(env, result);
-    }
-
-    // Store the db pointer in a JavaScript object for further use
-    Napi::Object dbObject = Napi::Object::New(env);
-    dbObject.Set("dbPointer", Napi::External<csqldb>::New(env, db));
-
-    return dbObject;
+    return (new ConnectWorker(env, host, port, username, password, timeout, CUBESQL_ENCRYPTION_SSL, true, ssl_certificate_path))->Start();
 }
 
-// Implementation for ExecuteSQL
-Napi::Value ExecuteSQL(const Napi::CallbackInfo& info) {
+// Implementation for ExecuteAsync
+Napi::Value ExecuteAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
@@ -96,20 +3405,17 @@ Napi::Value ExecuteSQL(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
     std::string sql = info[1].As<Napi::String>();
 
-    int result = cubesql_execute(db, sql.c_str());
-    return Napi::Number::New(env, result);
+    return (new StatusWorker(env, db, [db, sql]() { return cubesql_execute(db, sql.c_str()); }))->Start();
 }
 
-// Implementation for SelectSQL
-Napi::Value SelectSQL(const Napi::CallbackInfo& info) {
+// Implementation for ExecuteExAsync
+Napi::Value ExecuteExAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
@@ -117,164 +3423,155 @@ Napi::Value SelectSQL(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
     std::string sql = info[1].As<Napi::String>();
 
-    csqlc* cursor = cubesql_select(db, sql.c_str(), kFALSE);
-    if (!cursor) {
-        return env.Null();
-    }
-
-    // Store the cursor pointer in a JavaScript object for further use
-    Napi::Object cursorObject = Napi::Object::New(env);
-    cursorObject.Set("cursorPointer", Napi::External<csqlc>::New(env, cursor));
-
-    return cursorObject;
+    return (new ExecuteExWorker(env, db, sql))->Start();
 }
 
-// Implementation for CommitTransaction
-Napi::Value CommitTransaction(const Napi::CallbackInfo& info) {
+// Implementation for PipelineAsync
+Napi::Value PipelineAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), statements (array), options (object, optional)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    int result = cubesql_commit(db);
-    return Napi::Number::New(env, result);
+    std::unique_ptr<Batch> batch = std::make_unique<Batch>();
+    if (!GetBatch(env, info, batch.get())) {
+        return env.Null();
+    }
+    if (batch->transaction && ConnectionOf(db)->inTransaction) {
+        Napi::Error::New(env, "A transaction is already open on this connection").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return (new BatchWorker(env, db, std::move(batch)))->Start();
 }
 
-// Implementation for RollbackTransaction
-Napi::Value RollbackTransaction(const Napi::CallbackInfo& info) {
+// Implementation for SelectAsync
+Napi::Value SelectAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string), options (object, optional)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    int result = cubesql_rollback(db);
-    return Napi::Number::New(env, result);
+    std::string sql = info[1].As<Napi::String>();
+    int serverSide, prefetch, compression;
+    if (!GetSelectOptions(env, info, 2, &serverSide, &prefetch, &compression)) {
+        return env.Null();
+    }
+
+    return (new CursorWorker(env, db, [db, sql, serverSide, prefetch, compression]() {
+        csqlc* cursor = SelectWithCompression(db, sql, serverSide, compression);
+        if (cursor) cubesql_cursor_setprefetch(cursor, prefetch);
+        return cursor;
+    }))->Start();
 }
 
-// Implementation for BeginTransaction
-Napi::Value BeginTransaction(const Napi::CallbackInfo& info) {
+// Implementation for PrepareAsync
+Napi::Value PrepareAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    int result = cubesql_begintransaction(db);
-    return Napi::Number::New(env, result);
+    std::string sql = info[1].As<Napi::String>();
+    Connection* conn = ConnectionOf(db);
+    std::shared_ptr<CachedStatement> statement = conn->statements.Find(sql);
+    if (statement) {
+        // nothing to send: the statement is prepared again on its first use if the server dropped it
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(VM::NewInstance(env, statement, conn->shared_from_this()));
+        return deferred.Promise();
+    }
+
+    return (new PrepareWorker(env, db, sql))->Start();
 }
 
-// Implementation for BindSQL
-Napi::Value BindSQL(const Napi::CallbackInfo& info) {
+// Implementation for ExecuteManyAsync
+Napi::Value ExecuteManyAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 6 || !info[0].IsObject() || !info[1].IsString() ||
-        !info[2].IsArray() || !info[3].IsArray() || !info[4].IsArray() || !info[5].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string), colvalue (array), colsize (array), coltype (array), ncols (number)").ThrowAsJavaScriptException();
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string), rows (array or object), options (object, optional)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
     std::string sql = info[1].As<Napi::String>();
-
-    Napi::Array colvalueArray = info[2].As<Napi::Array>();
-    Napi::Array colsizeArray = info[3].As<Napi::Array>();
-    Napi::Array coltypeArray = info[4].As<Napi::Array>();
-    int ncols = info[5].As<Napi::Number>();
-
-    std::vector<char*> colvalue(ncols);
-    std::vector<int> colsize(ncols);
-    std::vector<int> coltype(ncols);
-
-    for (int i = 0; i < ncols; i++) {
-        colvalue[i] = strdup(colvalueArray.Get(i).As<Napi::String>().Utf8Value().c_str());
-        colsize[i] = colsizeArray.Get(i).As<Napi::Number>();
-        coltype[i] = coltypeArray.Get(i).As<Napi::Number>();
+    BindParams params;
+    bool transaction, changes;
+    if (!GetBindRows(env, info[2], &params) || !GetExecuteManyOptions(env, info, 3, &transaction, &changes)) {
+        return env.Null();
     }
-
-    int result = cubesql_bind(db, sql.c_str(), colvalue.data(), colsize.data(), coltype.data(), ncols);
-
-    for (int i = 0; i < ncols; i++) {
-        free(colvalue[i]);
+    if (transaction && ConnectionOf(db)->inTransaction) {
+        Napi::Error::New(env, "A transaction is already open on this connection").ThrowAsJavaScriptException();
+        return env.Null();
     }
-
-    return Napi::Number::New(env, result);
+    std::shared_ptr<CachedStatement> statement = ConnectionOf(db)->statements.Find(sql);
+    return (new ExecuteManyWorker(env, db, nullptr, sql, std::move(params), transaction, changes))->Cached(statement)->Start();
 }
 
-// Implementation for PingCubeSQL
-Napi::Value PingCubeSQL(const Napi::CallbackInfo& info) {
+// Implementation for SetDatabaseAsync
+Napi::Value SetDatabaseAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), dbname (string)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    int result = cubesql_ping(db);
-    return Napi::Number::New(env, result);
+    std::string dbname = info[1].As<Napi::String>();
+
+    return (new StatusWorker(env, db, [db, dbname]() { return cubesql_set_database(db, dbname.c_str()); }))->Start();
 }
 
-// Implementation for CancelCubeSQL
-void CancelCubeSQL(const Napi::CallbackInfo& info) {
+// Implementation for DisconnectAsync
+Napi::Value DisconnectAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsObject()) {
         Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
-        return;
+        return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
-        return;
+        return env.Null();
     }
-    cubesql_cancel(db);
+    return (new DisconnectWorker(env, db))->Start();
 }
 
-// Implementation for GetErrorCode
-Napi::Value GetErrorCode(const Napi::CallbackInfo& info) {
+// Implementation for CommitAsync
+Napi::Value CommitAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsObject()) {
@@ -282,18 +3579,15 @@ Napi::Value GetErrorCode(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    int result = cubesql_errcode(db);
-    return Napi::Number::New(env, result);
+    return (new StatusWorker(env, db, [db]() { return TrackTransaction(db, cubesql_commit(db), false); }))->Start();
 }
 
-// Implementation for GetErrorMessage
-Napi::Value GetErrorMessage(const Napi::CallbackInfo& info) {
+// Implementation for RollbackAsync
+Napi::Value RollbackAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsObject()) {
@@ -301,18 +3595,15 @@ Napi::Value GetErrorMessage(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    char* errmsg = cubesql_errmsg(db);
-    return Napi::String::New(env, errmsg);
+    return (new StatusWorker(env, db, [db]() { return TrackTransaction(db, cubesql_rollback(db), false); }))->Start();
 }
 
-// Implementation for GetChanges
-Napi::Value GetChanges(const Napi::CallbackInfo& info) {
+// Implementation for BeginTransactionAsync
+Napi::Value BeginTransactionAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsObject()) {
@@ -320,64 +3611,47 @@ Napi::Value GetChanges(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    int64_t changes = cubesql_changes(db);
-    return Napi::Number::New(env, static_cast<double>(changes));
+    return (new StatusWorker(env, db, [db]() { return TrackTransaction(db, cubesql_begintransaction(db), true); }))->Start();
 }
 
-// Implementation for SetTraceCallback
-void SetTraceCallback(const Napi::CallbackInfo& info) {
+// Implementation for PingAsync
+Napi::Value PingAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) {
-        Napi::TypeError::New(env, "Expected arguments: dbObject (object), callback (function)").ThrowAsJavaScriptException();
-        return;
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
-        return;
+        return env.Null();
     }
-    Napi::Function callback = info[1].As<Napi::Function>();
-    auto traceCallback = [](const char* message, void* data) {
-        Napi::FunctionReference* ref = static_cast<Napi::FunctionReference*>(data);
-        ref->Call({Napi::String::New(ref->Env(), message)});
-    };
-
-    auto* callbackRef = new Napi::FunctionReference(Napi::Persistent(callback));
-    cubesql_set_trace_callback(db, traceCallback, callbackRef);
+    return (new StatusWorker(env, db, [db]() { return cubesql_ping(db); }))->Start();
 }
 
-// Implementation for SetDatabase
-Napi::Value SetDatabase(const Napi::CallbackInfo& info) {
+// Implementation for SendEndDataAsync
+Napi::Value SendEndDataAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
-        Napi::TypeError::New(env, "Expected arguments: dbObject (object), dbname (string)").ThrowAsJavaScriptException();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    std::string dbname = info[1].As<Napi::String>();
-
-    int result = cubesql_set_database(db, dbname.c_str());
-    return Napi::Number::New(env, result);
+    return (new StatusWorker(env, db, [db]() { return cubesql_send_enddata(db); }))->Start();
 }
 
-// Implementation for GetAffectedRows
-Napi::Value GetAffectedRows(const Napi::CallbackInfo& info) {
+// Implementation for GetChangesAsync
+Napi::Value GetChangesAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsObject()) {
@@ -385,18 +3659,15 @@ Napi::Value GetAffectedRows(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    int64_t affectedRows = cubesql_affected_rows(db);
-    return Napi::Number::New(env, static_cast<double>(affectedRows));
+    return (new Int64Worker(env, db, [db]() { return cubesql_changes(db); }))->Start();
 }
 
-// Implementation for GetLastInsertedRowID
-Napi::Value GetLastInsertedRowID(const Napi::CallbackInfo& info) {
+// Implementation for GetAffectedRowsAsync
+Napi::Value GetAffectedRowsAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsObject()) {
@@ -404,53 +3675,31 @@ Napi::Value GetLastInsertedRowID(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    int64_t lastRowID = cubesql_last_inserted_rowID(db);
-    return Napi::Number::New(env, static_cast<double>(lastRowID));
-}
-
-// Implementation for SleepMilliseconds
-void SleepMilliseconds(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-
-    if (info.Length() < 1 || !info[0].IsNumber()) {
-        Napi::TypeError::New(env, "Expected argument: milliseconds (number)").ThrowAsJavaScriptException();
-        return;
-    }
-
-    int milliseconds = info[0].As<Napi::Number>();
-    cubesql_mssleep(milliseconds);
+    return (new Int64Worker(env, db, [db]() { return cubesql_affected_rows(db); }))->Start();
 }
 
-// Implementation for SendData
-Napi::Value SendData(const Napi::CallbackInfo& info) {
+// Implementation for GetLastInsertedRowIDAsync
+Napi::Value GetLastInsertedRowIDAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsBuffer() || !info[2].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: dbObject (object), buffer (Buffer), length (number)").ThrowAsJavaScriptException();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    Napi::Buffer<char> buffer = info[1].As<Napi::Buffer<char>>();
-    int length = info[2].As<Napi::Number>();
-
-    int result = cubesql_send_data(db, buffer.Data(), length);
-    return Napi::Number::New(env, result);
+    return (new Int64Worker(env, db, [db]() { return cubesql_last_inserted_rowID(db); }))->Start();
 }
 
-// Implementation for SendEndData
-Napi::Value SendEndData(const Napi::CallbackInfo& info) {
+// Implementation for ReceiveDataAsync
+Napi::Value ReceiveDataAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsObject()) {
@@ -458,76 +3707,66 @@ Napi::Value SendEndData(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    int result = cubesql_send_enddata(db);
-    return Napi::Number::New(env, result);
+    return (new ReceiveDataWorker(env, db))->Start();
 }
 
-// Implementation for ReceiveData
-Napi::Value ReceiveData(const Napi::CallbackInfo& info) {
+// Implementation for BindAsync
+Napi::Value BindAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string), values (array)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    int len = 0;
-    int is_end_chunk = 0;
-    char* data = cubesql_receive_data(db, &len, &is_end_chunk);
-
-    if (!data) {
+    std::string sql = info[1].As<Napi::String>();
+    std::shared_ptr<BindParams> params = std::make_shared<BindParams>();
+    if (!GetBindSQLParams(env, info, params.get())) {
         return env.Null();
     }
 
-    Napi::Object result = Napi::Object::New(env);
-    result.Set("data", Napi::Buffer<char>::Copy(env, data, len));
-    result.Set("isEndChunk", Napi::Boolean::New(env, is_end_chunk));
-
-    return result;
+    return (new StatusWorker(env, db, [db, sql, params]() {
+        params->Resolve();
+        return cubesql_bind(db, sql.c_str(), params->values.data(), params->lengths.data(), params->types.data(), params->Count());
+    }))->Start();
 }
 
-// Implementation for PrepareVM
-Napi::Value PrepareVM(const Napi::CallbackInfo& info) {
+// Implementation for SendDataAsync
+Napi::Value SendDataAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsString()) {
-        Napi::TypeError::New(env, "Expected arguments: dbObject (object), sql (string)").ThrowAsJavaScriptException();
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsBuffer() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: dbObject (object), buffer (Buffer), length (number)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object dbObject = info[0].As<Napi::Object>();
-    csqldb* db = dbObject.Get("dbPointer").As<Napi::External<csqldb>>().Data();
+    csqldb* db = GetDatabasePointer(env, info[0]);
     if (!db) {
-        Napi::Error::New(env, "Invalid database pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    std::string sql = info[1].As<Napi::String>();
-
-    csqlvm* vm = cubesql_vmprepare(db, sql.c_str());
-    if (!vm) {
+    Napi::Buffer<char> buffer = info[1].As<Napi::Buffer<char>>();
+    int length = info[2].As<Napi::Number>();
+    if (length < 0 || static_cast<size_t>(length) > buffer.Length()) {
+        Napi::RangeError::New(env, "length exceeds buffer size").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object vmObject = Napi::Object::New(env);
-    vmObject.Set("vmPointer", Napi::External<csqlvm>::New(env, vm));
+    // The worker thread cannot touch JS memory, so the payload is copied up front
+    std::string data(buffer.Data(), length);
 
-    return vmObject;
+    return (new StatusWorker(env, db, [db, data]() { return cubesql_send_data(db, data.data(), static_cast<int>(data.size())); }))->Start();
 }
 
-// Implementation for BindVMInt
-Napi::Value BindVMInt(const Napi::CallbackInfo& info) {
+// Implementation for BindVMIntAsync
+Napi::Value BindVMIntAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
@@ -535,21 +3774,18 @@ Napi::Value BindVMInt(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object vmObject = info[0].As<Napi::Object>();
-    csqlvm* vm = vmObject.Get("vmPointer").As<Napi::External<csqlvm>>().Data();
+    csqlvm* vm = GetVMPointer(env, info[0]);
     if (!vm) {
-        Napi::Error::New(env, "Invalid VM pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
     int index = info[1].As<Napi::Number>();
     int intValue = info[2].As<Napi::Number>();
 
-    int result = cubesql_vmbind_int(vm, index, intValue);
-    return Napi::Number::New(env, result);
+    return (new StatusWorker(env, cubesql_vm_db(vm), [vm, index, intValue]() { return cubesql_vmbind_int(vm, index, intValue); }))->Retain(info[0])->Start();
 }
 
-// Implementation for BindVMDouble
-Napi::Value BindVMDouble(const Napi::CallbackInfo& info) {
+// Implementation for BindVMDoubleAsync
+Napi::Value BindVMDoubleAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
@@ -557,21 +3793,18 @@ Napi::Value BindVMDouble(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object vmObject = info[0].As<Napi::Object>();
-    csqlvm* vm = vmObject.Get("vmPointer").As<Napi::External<csqlvm>>().Data();
+    csqlvm* vm = GetVMPointer(env, info[0]);
     if (!vm) {
-        Napi::Error::New(env, "Invalid VM pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
     int index = info[1].As<Napi::Number>();
     double doubleValue = info[2].As<Napi::Number>();
 
-    int result = cubesql_vmbind_double(vm, index, doubleValue);
-    return Napi::Number::New(env, result);
+    return (new StatusWorker(env, cubesql_vm_db(vm), [vm, index, doubleValue]() { return cubesql_vmbind_double(vm, index, doubleValue); }))->Retain(info[0])->Start();
 }
 
-// Implementation for BindVMText
-Napi::Value BindVMText(const Napi::CallbackInfo& info) {
+// Implementation for BindVMTextAsync
+Napi::Value BindVMTextAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsString()) {
@@ -579,132 +3812,100 @@ Napi::Value BindVMText(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object vmObject = info[0].As<Napi::Object>();
-    csqlvm* vm = vmObject.Get("vmPointer").As<Napi::External<csqlvm>>().Data();
+    csqlvm* vm = GetVMPointer(env, info[0]);
     if (!vm) {
-        Napi::Error::New(env, "Invalid VM pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
     int index = info[1].As<Napi::Number>();
     std::string textValue = info[2].As<Napi::String>();
 
-    int result = cubesql_vmbind_text(vm, index, const_cast<char*>(textValue.c_str()), textValue.length());
-    return Napi::Number::New(env, result);
+    return (new StatusWorker(env, cubesql_vm_db(vm), [vm, index, textValue]() { return cubesql_vmbind_text(vm, index, const_cast<char*>(textValue.c_str()), static_cast<int>(textValue.length())); }))->Retain(info[0])->Start();
 }
 
-// Implementation for BindVMNull
-Napi::Value BindVMNull(const Napi::CallbackInfo& info) {
+// Implementation for BindVMAsync
+Napi::Value BindVMAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number)").ThrowAsJavaScriptException();
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number), value").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object vmObject = info[0].As<Napi::Object>();
-    csqlvm* vm = vmObject.Get("vmPointer").As<Napi::External<csqlvm>>().Data();
+    csqlvm* vm = GetVMPointer(env, info[0]);
     if (!vm) {
-        Napi::Error::New(env, "Invalid VM pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
     int index = info[1].As<Napi::Number>();
+    std::shared_ptr<BindParams> params = std::make_shared<BindParams>();
+    params->Reset(1, 1);
+    if (!SetBindValue(env, info[2], params.get(), 0, -1, index - 1)) {
+        return env.Null();
+    }
 
-    int result = cubesql_vmbind_null(vm, index);
-    return Napi::Number::New(env, result);
+    return (new StatusWorker(env, cubesql_vm_db(vm), [vm, index, params]() {
+        params->Resolve();
+        return cubesql_vmbind_value(vm, index, params->types[0], params->values[0], params->lengths[0]);
+    }))->Retain(info[0])->Start();
 }
 
-// Implementation for BindVMInt64
-Napi::Value BindVMInt64(const Napi::CallbackInfo& info) {
+// Implementation for BindVMNullAsync
+Napi::Value BindVMNullAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number), int64Value (number)").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object vmObject = info[0].As<Napi::Object>();
-    csqlvm* vm = vmObject.Get("vmPointer").As<Napi::External<csqlvm>>().Data();
+    csqlvm* vm = GetVMPointer(env, info[0]);
     if (!vm) {
-        Napi::Error::New(env, "Invalid VM pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
     int index = info[1].As<Napi::Number>();
-    int64_t int64Value = info[2].As<Napi::Number>().Int64Value();
 
-    int result = cubesql_vmbind_int64(vm, index, int64Value);
-    return Napi::Number::New(env, result);
+    return (new StatusWorker(env, cubesql_vm_db(vm), [vm, index]() { return cubesql_vmbind_null(vm, index); }))->Retain(info[0])->Start();
 }
 
-// Implementation for BindVMZeroBlob
-Napi::Value BindVMZeroBlob(const Napi::CallbackInfo& info) {
+// Implementation for BindVMInt64Async
+Napi::Value BindVMInt64Async(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number), length (number)").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number), int64Value (number)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object vmObject = info[0].As<Napi::Object>();
-    csqlvm* vm = vmObject.Get("vmPointer").As<Napi::External<csqlvm>>().Data();
+    csqlvm* vm = GetVMPointer(env, info[0]);
     if (!vm) {
-        Napi::Error::New(env, "Invalid VM pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
     int index = info[1].As<Napi::Number>();
-    int length = info[2].As<Napi::Number>();
-
-    int result = cubesql_vmbind_zeroblob(vm, index, length);
-    return Napi::Number::New(env, result);
-}
-
-// Implementation for ExecuteVM
-Napi::Value ExecuteVM(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: vmObject (object)").ThrowAsJavaScriptException();
-        return env.Null();
-    }
+    int64 int64Value = info[2].As<Napi::Number>().Int64Value();
 
-    Napi::Object vmObject = info[0].As<Napi::Object>();
-    csqlvm* vm = vmObject.Get("vmPointer").As<Napi::External<csqlvm>>().Data();
-    if (!vm) {
-        Napi::Error::New(env, "Invalid VM pointer").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-    int result = cubesql_vmexecute(vm);
-    return Napi::Number::New(env, result);
+    return (new StatusWorker(env, cubesql_vm_db(vm), [vm, index, int64Value]() { return cubesql_vmbind_int64(vm, index, int64Value); }))->Retain(info[0])->Start();
 }
 
-// Implementation for SelectVM
-Napi::Value SelectVM(const Napi::CallbackInfo& info) {
+// Implementation for BindVMZeroBlobAsync
+Napi::Value BindVMZeroBlobAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: vmObject (object)").ThrowAsJavaScriptException();
-        return env.Null();
-    }
-
-    Napi::Object vmObject = info[0].As<Napi::Object>();
-    csqlvm* vm = vmObject.Get("vmPointer").As<Napi::External<csqlvm>>().Data();
-    if (!vm) {
-        Napi::Error::New(env, "Invalid VM pointer").ThrowAsJavaScriptException();
+    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), index (number), length (number)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    csqlc* cursor = cubesql_vmselect(vm);
-    if (!cursor) {
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
         return env.Null();
     }
+    int index = info[1].As<Napi::Number>();
+    int length = info[2].As<Napi::Number>();
 
-    Napi::Object cursorObject = Napi::Object::New(env);
-    cursorObject.Set("cursorPointer", Napi::External<csqlc>::New(env, cursor));
-
-    return cursorObject;
+    return (new StatusWorker(env, cubesql_vm_db(vm), [vm, index, length]() { return cubesql_vmbind_zeroblob(vm, index, length); }))->Retain(info[0])->Start();
 }
 
-// Implementation for CloseVM
-Napi::Value CloseVM(const Napi::CallbackInfo& info) {
+// Implementation for ExecuteVMAsync
+Napi::Value ExecuteVMAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsObject()) {
@@ -712,401 +3913,1047 @@ Napi::Value CloseVM(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    Napi::Object vmObject = info[0].As<Napi::Object>();
-    csqlvm* vm = vmObject.Get("vmPointer").As<Napi::External<csqlvm>>().Data();
+    csqlvm* vm = GetVMPointer(env, info[0]);
     if (!vm) {
-        Napi::Error::New(env, "Invalid VM pointer").ThrowAsJavaScriptException();
         return env.Null();
     }
-    int result = cubesql_vmclose(vm);
-    return Napi::Number::New(env, result);
+    return (new StatusWorker(env, cubesql_vm_db(vm), [vm]() { return cubesql_vmexecute(vm); }))->Retain(info[0])->Start();
 }
 
-// Implementation for GetCursorNumRows
-Napi::Value GetCursorNumRows(const Napi::CallbackInfo& info) {
+// Implementation for SelectVMAsync
+Napi::Value SelectVMAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: cursorObject (object)").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected argument: vmObject (object)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
         return env.Null();
     }
-    int result = cubesql_cursor_numrows(cursor);
-    return Napi::Number::New(env, result);
+    return (new CursorWorker(env, cubesql_vm_db(vm), [vm]() { return cubesql_vmselect(vm); }))->Retain(info[0])->Start();
 }
 
-// Implementation for GetCursorNumColumns
-Napi::Value GetCursorNumColumns(const Napi::CallbackInfo& info) {
+// Implementation for BindExecuteVMAsync
+Napi::Value BindExecuteVMAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: cursorObject (object)").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), params (array)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
         return env.Null();
     }
-    int result = cubesql_cursor_numcolumns(cursor);
-    return Napi::Number::New(env, result);
+    BindParams params;
+    if (!GetBindParams(env, info[1], &params)) {
+        return env.Null();
+    }
+    return (new BindExecuteWorker(env, vm, std::move(params), false))->Retain(info[0])->Start();
 }
 
-// Implementation for GetCursorCurrentRow
-Napi::Value GetCursorCurrentRow(const Napi::CallbackInfo& info) {
+// Implementation for BindSelectVMAsync
+Napi::Value BindSelectVMAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: cursorObject (object)").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), params (array)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
         return env.Null();
     }
-    int result = cubesql_cursor_currentrow(cursor);
-    return Napi::Number::New(env, result);
+    BindParams params;
+    if (!GetBindParams(env, info[1], &params)) {
+        return env.Null();
+    }
+    return (new BindExecuteWorker(env, vm, std::move(params), true))->Retain(info[0])->Start();
 }
 
-// Implementation for SeekCursor
-Napi::Value SeekCursor(const Napi::CallbackInfo& info) {
+// Implementation for ExecuteManyVMAsync
+Napi::Value ExecuteManyVMAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), index (number)").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected arguments: vmObject (object), rows (array or object), options (object, optional)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
+    csqlvm* vm = GetVMPointer(env, info[0]);
+    if (!vm) {
         return env.Null();
     }
-    int index = info[1].As<Napi::Number>();
-
-    int result = cubesql_cursor_seek(cursor, index);
-    return Napi::Number::New(env, result);
+    BindParams params;
+    bool transaction, changes;
+    if (!GetBindRows(env, info[1], &params) || !GetExecuteManyOptions(env, info, 2, &transaction, &changes)) {
+        return env.Null();
+    }
+    if (transaction && ConnectionOf(cubesql_vm_db(vm))->inTransaction) {
+        Napi::Error::New(env, "A transaction is already open on this connection").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return (new ExecuteManyWorker(env, cubesql_vm_db(vm), vm, std::string(), std::move(params), transaction, changes))->Retain(info[0])->Start();
 }
 
-// Implementation for IsCursorEOF
-Napi::Value IsCursorEOF(const Napi::CallbackInfo& info) {
+// Implementation for CloseVMAsync
+Napi::Value CloseVMAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
     if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: cursorObject (object)").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected argument: vmObject (object)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
+    VM* handle = UnwrapVM(env, info[0]);
+    if (!handle) {
         return env.Null();
     }
-    int result = cubesql_cursor_iseof(cursor);
-    return Napi::Boolean::New(env, result);
+    // The wrapper lets go of the VM right away so nothing can use it while the close is queued
+    csqlvm* vm = handle->vm;
+    handle->vm = nullptr;
+    if (handle->cached) {
+        // the statement stays in the cache
+        handle->cached.reset();
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(env.Undefined());
+        return deferred.Promise();
+    }
+    return (new StatusWorker(env, cubesql_vm_db(vm), [vm]() { return cubesql_vmclose(vm); }))->Start();
 }
 
-// Implementation for GetCursorColumnType
-Napi::Value GetCursorColumnType(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+// MARK: - Pool
+
+// Connection settings and sizing of a Pool
+struct PoolOptions {
+    std::string host;
+    int port = CUBESQL_DEFAULT_PORT;
+    std::string username;
+    std::string password;
+    int timeout = CUBESQL_DEFAULT_TIMEOUT;
+    int encryption = CUBESQL_ENCRYPTION_NONE;
+    std::string sslCertificatePath;  // connects with TLS when set
+    std::string database;            // selected on every new connection when set
+    bool dedicatedThreads = false;   // every connection runs its calls on a thread of its own
+    size_t statementCache = 0;       // capacity of every connection's statement cache
+    bool compression = false;        // applies compressionOptions to every connection
+    CompressionOptions compressionOptions;
+    int resultCompression = CUBESQL_COMPRESSION_ON;  // result compression mode of every connection
+    size_t min = 0;
+    size_t max = 10;
+    std::chrono::milliseconds pingAfter{30000};    // a connection idle this long is pinged before it is reused
+    std::chrono::milliseconds idleTimeout{60000};  // connections above min idle this long are closed
+};
+
+// A connection owned by a pool, together with the Database object acquire() hands out
+struct PoolEntry {
+    Napi::ObjectReference database;
+    std::shared_ptr<Connection> conn;
+    std::chrono::steady_clock::time_point idleSince;
+    bool pinned = false;  // checked out by acquire() or transaction() until release()
+};
+
+// Keeps between min and max connections open and gives every call its own idle connection, so N calls
+// in flight run on N connections at once. All pool state is owned by the JS thread: checkout and return
+// are plain container operations without any locking, only the round trips run on worker threads.
+class Pool : public Napi::ObjectWrap<Pool> {
+public:
+    // Receives a connection, or the error when none could be opened
+    using Delivery = std::function<void(Napi::Env env, PoolEntry* entry, Napi::Value error)>;
+
+    Pool(const Napi::CallbackInfo& info);
+    ~Pool();
+    static Napi::Function Init(Napi::Env env);
+
+    template <auto Fn>
+    Napi::Value Method(const Napi::CallbackInfo& info) {
+        return Invoke<Fn>(CallArgs(info, true));
+    }
 
-    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), index (number)").ThrowAsJavaScriptException();
-        return env.Null();
+    void Acquire(Napi::Env env, Delivery delivery);
+    void Release(Napi::Env env, PoolEntry* entry, int errcode);
+    Napi::Promise Run(Napi::Env env, std::function<ConnectionWorker*(Napi::Env, csqldb*)> call);
+    void Grow(Napi::Env env, Delivery delivery);
+    void Evict(Napi::Env env, PoolEntry* entry, bool gracefully);
+    PoolEntry* Find(const Connection* conn) const;
+    void StopPruneTimer();
+
+    PoolOptions options;
+    std::vector<std::unique_ptr<PoolEntry>> entries;  // every open connection
+    std::deque<PoolEntry*> idle;                       // most recently used at the back
+    std::deque<Delivery> waiters;                      // calls waiting for a connection
+    size_t opening = 0;                                // connects in flight
+    bool closed = false;
+
+private:
+    void Wake(Napi::Env env);
+    void Prune(Napi::Env env);
+    void StartPruneTimer(Napi::Env env);
+    static void OnPruneTimer(uv_timer_t* timer);
+    static void Cleanup(void* arg);
+
+    uv_timer_t* pruneTimer = nullptr;  // unref'ed, so it never keeps the process alive
+};
+
+static Pool* UnwrapPool(Napi::Env env, const Napi::Value& value) {
+    if (!value.IsObject() || !value.As<Napi::Object>().CheckTypeTag(&kPoolTypeTag)) {
+        Napi::TypeError::New(env, "Invalid pool object").ThrowAsJavaScriptException();
+        return nullptr;
     }
+    return Pool::Unwrap(value.As<Napi::Object>());
+}
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
-        return env.Null();
+// Reads { host, port, username, password, timeout, encryption, sslCertificatePath, database,
+// min, max, pingAfter, idleTimeout, dedicatedThreads, statementCache, compression, resultCompression };
+// only host is required
+static bool GetPoolOptions(Napi::Env env, const Napi::Value& value, PoolOptions* options) {
+    if (!value.IsObject() || !value.As<Napi::Object>().Get("host").IsString()) {
+        Napi::TypeError::New(env, "Expected argument: options (object with a host string)").ThrowAsJavaScriptException();
+        return false;
     }
-    int index = info[1].As<Napi::Number>();
+    Napi::Object object = value.As<Napi::Object>();
+
+    auto text = [&](const char* name, std::string* target) {
+        Napi::Value option = object.Get(name);
+        if (option.IsUndefined()) return true;
+        if (!option.IsString()) {
+            Napi::TypeError::New(env, std::string("Pool option ") + name + " must be a string").ThrowAsJavaScriptException();
+            return false;
+        }
+        *target = option.As<Napi::String>().Utf8Value();
+        return true;
+    };
+    auto number = [&](const char* name, double* target) {
+        Napi::Value option = object.Get(name);
+        if (option.IsUndefined()) return true;
+        if (!option.IsNumber() || option.As<Napi::Number>().DoubleValue() < 0) {
+            Napi::TypeError::New(env, std::string("Pool option ") + name + " must be a non-negative number").ThrowAsJavaScriptException();
+            return false;
+        }
+        *target = option.As<Napi::Number>().DoubleValue();
+        return true;
+    };
 
-    int result = cubesql_cursor_columntype(cursor, index);
-    return Napi::Number::New(env, result);
+    Napi::Value dedicatedThreads = object.Get("dedicatedThreads");
+    if (!dedicatedThreads.IsUndefined() && !dedicatedThreads.IsBoolean()) {
+        Napi::TypeError::New(env, "Pool option dedicatedThreads must be a boolean").ThrowAsJavaScriptException();
+        return false;
+    }
+    options->dedicatedThreads = dedicatedThreads.IsBoolean() && dedicatedThreads.As<Napi::Boolean>().Value();
+
+    Napi::Value compression = object.Get("compression");
+    if (!compression.IsUndefined()) {
+        if (!GetCompressionOptions(env, compression, &options->compressionOptions)) return false;
+        options->compression = true;
+    }
+    Napi::Value resultCompression = object.Get("resultCompression");
+    if (!resultCompression.IsUndefined() && !GetCompressionMode(env, resultCompression, &options->resultCompression)) return false;
+
+    double port = options->port, timeout = options->timeout, encryption = options->encryption;
+    double min = static_cast<double>(options->min), max = static_cast<double>(options->max);
+    double pingAfter = static_cast<double>(options->pingAfter.count());
+    double idleTimeout = static_cast<double>(options->idleTimeout.count());
+    double statementCache = static_cast<double>(options->statementCache);
+    if (!text("host", &options->host) || !text("username", &options->username) || !text("password", &options->password) ||
+        !text("sslCertificatePath", &options->sslCertificatePath) || !text("database", &options->database) ||
+        !number("port", &port) || !number("timeout", &timeout) || !number("encryption", &encryption) ||
+        !number("min", &min) || !number("max", &max) || !number("pingAfter", &pingAfter) || !number("idleTimeout", &idleTimeout) ||
+        !number("statementCache", &statementCache)) {
+        return false;
+    }
+    if (max < 1 || min > max) {
+        Napi::RangeError::New(env, "Pool option max must be at least 1 and not below min").ThrowAsJavaScriptException();
+        return false;
+    }
+
+    options->port = static_cast<int>(port);
+    options->timeout = static_cast<int>(timeout);
+    options->encryption = static_cast<int>(encryption);
+    options->min = static_cast<size_t>(min);
+    options->max = static_cast<size_t>(max);
+    options->pingAfter = std::chrono::milliseconds(static_cast<int64_t>(pingAfter));
+    options->idleTimeout = std::chrono::milliseconds(static_cast<int64_t>(idleTimeout));
+    options->statementCache = static_cast<size_t>(statementCache);
+    return true;
 }
 
-// Implementation for GetCursorField
-Napi::Value GetCursorField(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+Pool::Pool(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Pool>(info) {
+    if (!GetPoolOptions(info.Env(), info[0], &options)) return;
+    info.This().As<Napi::Object>().TypeTag(&kPoolTypeTag);
+    StartPruneTimer(info.Env());
+}
 
-    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number)").ThrowAsJavaScriptException();
-        return env.Null();
-    }
+Pool::~Pool() {
+    StopPruneTimer();
+}
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
-        return env.Null();
+// Hands out the most recently used idle connection, pinging it first only when it sat idle for
+// pingAfter; otherwise opens a new one while below max, or queues the caller
+void Pool::Acquire(Napi::Env env, Delivery delivery) {
+    if (closed) {
+        delivery(env, nullptr, Napi::Error::New(env, "Pool is closed").Value());
+        return;
     }
-    int row = info[1].As<Napi::Number>();
-    int column = info[2].As<Napi::Number>();
+    Prune(env);
+    while (!idle.empty()) {
+        PoolEntry* entry = idle.back();
+        idle.pop_back();
+        if (!entry->conn->db) {
+            Evict(env, entry, false);
+            continue;
+        }
+        if (std::chrono::steady_clock::now() - entry->idleSince < options.pingAfter) {
+            delivery(env, entry, Napi::Value());
+            return;
+        }
+
+        // The server or a firewall may have dropped it meanwhile: a broken connection is evicted and the next one tried
+        csqldb* db = entry->conn->db;
+        Ref();
+        (new StatusWorker(env, db, [db]() { return cubesql_ping(db); }))->Quiet()->WhenDone([this, entry, delivery](Napi::Env env, int errcode) {
+            Unref();
+            if (errcode == CUBESQL_NOERR) {
+                delivery(env, entry, Napi::Value());
+            } else {
+                Evict(env, entry, false);
+                Acquire(env, delivery);
+            }
+        })->Start();
+        return;
+    }
+    if (entries.size() + opening < options.max) {
+        Grow(env, std::move(delivery));
+        return;
+    }
+    waiters.push_back(std::move(delivery));
+}
 
-    int len = 0;
-    char* field = cubesql_cursor_field(cursor, row, column, &len);
+// Takes a connection back after a call completed with errcode. A broken connection is closed
+// instead; a transaction left open is rolled back before anybody else gets the connection.
+void Pool::Release(Napi::Env env, PoolEntry* entry, int errcode) {
+    Connection* conn = entry->conn.get();
+    entry->pinned = false;
+    if (ConnectionBroken(errcode) || !conn->db || closed) {
+        Evict(env, entry, !ConnectionBroken(errcode));
+        Wake(env);
+        return;
+    }
+    if (conn->inTransaction) {
+        csqldb* db = conn->db;
+        Ref();
+        (new StatusWorker(env, db, [db]() { return TrackTransaction(db, cubesql_rollback(db), false); }))->Quiet()->WhenDone([this, entry](Napi::Env env, int errcode) {
+            Unref();
+            Release(env, entry, (errcode == CUBESQL_NOERR) ? CUBESQL_NOERR : CUBESQL_ERR);
+        })->Start();
+        return;
+    }
 
-    if (!field) {
-        return env.Null();
+    entry->idleSince = std::chrono::steady_clock::now();
+    if (!waiters.empty()) {
+        Delivery next = std::move(waiters.front());
+        waiters.pop_front();
+        next(env, entry, Napi::Value());
+        return;
     }
+    idle.push_back(entry);
+    Prune(env);
+}
 
-    return Napi::String::New(env, std::string(field, len));
+// Runs one call on a pooled connection and takes the connection back when the call completes
+Napi::Promise Pool::Run(Napi::Env env, std::function<ConnectionWorker*(Napi::Env, csqldb*)> call) {
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    Ref();
+    Acquire(env, [this, deferred, call](Napi::Env env, PoolEntry* entry, Napi::Value error) {
+        if (!entry) {
+            Unref();
+            deferred.Reject(error);
+            return;
+        }
+        call(env, entry->conn->db)->Settles(deferred)->WhenDone([this, entry](Napi::Env env, int errcode) {
+            Unref();
+            Release(env, entry, errcode);
+        })->Start();
+    });
+    return deferred.Promise();
 }
 
-Napi::Value GetCursorFieldBuffer(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+// Opens one more connection on a worker thread
+void Pool::Grow(Napi::Env env, Delivery delivery) {
+    bool ssl = !options.sslCertificatePath.empty();
+    ConnectWorker* worker = new ConnectWorker(env, options.host, options.port, options.username, options.password,
+                                              options.timeout, ssl ? CUBESQL_ENCRYPTION_SSL : options.encryption,
+                                              ssl, options.sslCertificatePath);
+    opening++;
+    Ref();
+    worker->UseDatabase(options.database)->Start([this, delivery](Napi::Env env, Napi::Value result, bool ok) {
+        opening--;
+        Unref();
+        if (!ok) {
+            delivery(env, nullptr, result);
+            Wake(env);
+            return;
+        }
+
+        std::unique_ptr<PoolEntry> entry = std::make_unique<PoolEntry>();
+        entry->database = Napi::Persistent(result.As<Napi::Object>());
+        entry->conn = Database::Unwrap(result.As<Napi::Object>())->conn;
+        if (options.dedicatedThreads) entry->conn->SetDedicatedThread(std::make_unique<IOThread>(env));
+        entry->conn->statements.SetCapacity(options.statementCache);
+        if (options.compression) {
+            const CompressionOptions& compression = options.compressionOptions;
+            cubesql_set_compression(entry->conn->db, compression.level, compression.minSize, compression.statements ? kTRUE : kFALSE);
+        }
+        cubesql_set_result_compression(entry->conn->db, options.resultCompression);
+        PoolEntry* created = entry.get();
+        entries.push_back(std::move(entry));
+        if (closed) {
+            Evict(env, created, true);
+            delivery(env, nullptr, Napi::Error::New(env, "Pool is closed").Value());
+            return;
+        }
+        delivery(env, created, Napi::Value());
+    });
+}
 
-    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number)").ThrowAsJavaScriptException();
-        return env.Null();
+// Drops a connection from the pool. A healthy one is closed on a worker thread like disconnectAsync,
+// a broken one is just cut off.
+void Pool::Evict(Napi::Env env, PoolEntry* entry, bool gracefully) {
+    std::shared_ptr<Connection> conn = entry->conn;
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->get() == entry) {
+            entries.erase(it);
+            break;
+        }
+    }
+    if (!conn->db) return;
+    if (gracefully) {
+        (new DisconnectWorker(env, conn->db))->Quiet()->Start();
+    } else {
+        conn->Close(kFALSE);
     }
+}
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
-        return env.Null();
+PoolEntry* Pool::Find(const Connection* conn) const {
+    for (const std::unique_ptr<PoolEntry>& entry : entries) {
+        if (entry->conn.get() == conn) return entry.get();
     }
-    int row = info[1].As<Napi::Number>();
-    int column = info[2].As<Napi::Number>();
+    return nullptr;
+}
 
-    int len = 0;
-    char* field = cubesql_cursor_field(cursor, row, column, &len);
+// Opens a connection for the first waiter once there is room again
+void Pool::Wake(Napi::Env env) {
+    if (waiters.empty() || closed || entries.size() + opening >= options.max) return;
+    Delivery next = std::move(waiters.front());
+    waiters.pop_front();
+    Grow(env, std::move(next));
+}
 
-    if (!field) {
-        return env.Null();
+// Closes connections that sat idle for idleTimeout while the pool holds more than min. The oldest
+// idle connections are at the front. Runs whenever the pool is used and from a periodic timer, so a
+// pool that goes quiet still shrinks back to min.
+void Pool::Prune(Napi::Env env) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    while (!idle.empty() && entries.size() > options.min && now - idle.front()->idleSince >= options.idleTimeout) {
+        PoolEntry* entry = idle.front();
+        idle.pop_front();
+        Evict(env, entry, true);
     }
+}
 
-    // Return binary data as Napi::Buffer (instead of a string)
-    return Napi::Buffer<char>::New(env, field, len);
+// Checks twice per idleTimeout, so a connection stays at most half of it longer than idleTimeout
+void Pool::StartPruneTimer(Napi::Env env) {
+    uv_loop_t* loop = nullptr;
+    if (napi_get_uv_event_loop(env, &loop) != napi_ok || !loop) return;
+    uint64_t period = std::max<uint64_t>(static_cast<uint64_t>(options.idleTimeout.count()) / 2, 1000);
+    pruneTimer = new uv_timer_t;
+    uv_timer_init(loop, pruneTimer);
+    pruneTimer->data = this;
+    uv_timer_start(pruneTimer, OnPruneTimer, period, period);
+    uv_unref(reinterpret_cast<uv_handle_t*>(pruneTimer));
+    napi_add_env_cleanup_hook(env, Cleanup, this);
 }
 
-// Implementation for GetCursorRowID
-Napi::Value GetCursorRowID(const Napi::CallbackInfo& info) {
+// Called by close(), by the destructor and when Node tears the environment down
+void Pool::StopPruneTimer() {
+    if (!pruneTimer) return;
+    napi_remove_env_cleanup_hook(Env(), Cleanup, this);
+    uv_timer_stop(pruneTimer);
+    uv_close(reinterpret_cast<uv_handle_t*>(pruneTimer), [](uv_handle_t* handle) {
+        delete reinterpret_cast<uv_timer_t*>(handle);
+    });
+    pruneTimer = nullptr;
+}
+
+void Pool::OnPruneTimer(uv_timer_t* timer) {
+    Pool* pool = static_cast<Pool*>(timer->data);
+    Napi::Env env = pool->Env();
+    Napi::HandleScope scope(env);
+    pool->Prune(env);
+}
+
+void Pool::Cleanup(void* arg) {
+    static_cast<Pool*>(arg)->StopPruneTimer();
+}
+
+// Resolves with the Database object itself once the transaction has begun
+class TransactionWorker : public StatusWorker {
+public:
+    TransactionWorker(Napi::Env env, csqldb* db, Napi::Object database)
+        : StatusWorker(env, db, [db]() { return TrackTransaction(db, cubesql_begintransaction(db), true); }),
+          database(Napi::Persistent(database)) {}
+
+protected:
+    Napi::Value Result(Napi::Env env) override {
+        return database.Value();
+    }
+
+private:
+    Napi::ObjectReference database;
+};
+
+// Implementation for PoolOpen: opens connections up to min, all at once on separate worker threads
+Napi::Value PoolOpen(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number)").ThrowAsJavaScriptException();
+    Pool* pool = UnwrapPool(env, info[0]);
+    if (!pool) {
         return env.Null();
     }
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
-        return env.Null();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    size_t count = pool->entries.size() + pool->opening;
+    if (pool->closed) {
+        deferred.Reject(Napi::Error::New(env, "Pool is closed").Value());
+        return deferred.Promise();
+    }
+    if (count >= pool->options.min) {
+        deferred.Resolve(env.Undefined());
+        return deferred.Promise();
     }
-    int row = info[1].As<Napi::Number>();
 
-    int64_t rowID = cubesql_cursor_rowid(cursor, row);
-    return Napi::Number::New(env, static_cast<double>(rowID));
+    // Settles once every connect has completed, rejecting with the first failure
+    struct Warmup {
+        size_t remaining;
+        Napi::ObjectReference error;
+    };
+    std::shared_ptr<Warmup> warmup = std::make_shared<Warmup>();
+    warmup->remaining = pool->options.min - count;
+    pool->Ref();
+    for (size_t i = pool->options.min - count; i > 0; i--) {
+        pool->Grow(env, [pool, deferred, warmup](Napi::Env env, PoolEntry* entry, Napi::Value error) {
+            if (entry) {
+                pool->Release(env, entry, CUBESQL_NOERR);
+            } else if (warmup->error.IsEmpty()) {
+                warmup->error = Napi::Persistent(error.As<Napi::Object>());
+            }
+            if (--warmup->remaining > 0) return;
+            pool->Unref();
+            if (warmup->error.IsEmpty()) {
+                deferred.Resolve(env.Undefined());
+            } else {
+                deferred.Reject(warmup->error.Value());
+            }
+        });
+    }
+    return deferred.Promise();
 }
 
-// Implementation for GetCursorInt64
-Napi::Value GetCursorInt64(const Napi::CallbackInfo& info) {
+// Implementation for PoolAcquire: the connection stays checked out until release()
+Napi::Value PoolAcquire(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 4 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number), defaultValue (number)").ThrowAsJavaScriptException();
+    Pool* pool = UnwrapPool(env, info[0]);
+    if (!pool) {
         return env.Null();
     }
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    pool->Ref();
+    pool->Acquire(env, [pool, deferred](Napi::Env env, PoolEntry* entry, Napi::Value error) {
+        pool->Unref();
+        if (!entry) {
+            deferred.Reject(error);
+            return;
+        }
+        entry->pinned = true;
+        deferred.Resolve(entry->database.Value());
+    });
+    return deferred.Promise();
+}
+
+// Implementation for PoolTransaction: checks out a connection with a transaction begun on it. The connection
+// stays pinned to the caller until release(), which rolls back a transaction that was not committed.
+Napi::Value PoolTransaction(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    Pool* pool = UnwrapPool(env, info[0]);
+    if (!pool) {
         return env.Null();
     }
-    int row = info[1].As<Napi::Number>();
-    int column = info[2].As<Napi::Number>();
-    int64_t defaultValue = info[3].As<Napi::Number>().Int64Value();
 
-    int64_t result = cubesql_cursor_int64(cursor, row, column, defaultValue);
-    return Napi::Number::New(env, static_cast<double>(result));
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    pool->Ref();
+    pool->Acquire(env, [pool, deferred](Napi::Env env, PoolEntry* entry, Napi::Value error) {
+        if (!entry) {
+            pool->Unref();
+            deferred.Reject(error);
+            return;
+        }
+        entry->pinned = true;
+        (new TransactionWorker(env, entry->conn->db, entry->database.Value()))->Settles(deferred)->WhenDone([pool, entry](Napi::Env env, int errcode) {
+            pool->Unref();
+            if (errcode != CUBESQL_NOERR) pool->Release(env, entry, errcode);
+        })->Start();
+    });
+    return deferred.Promise();
 }
 
-// Implementation for GetCursorInt
-Napi::Value GetCursorInt(const Napi::CallbackInfo& info) {
+// Implementation for PoolRelease
+void PoolRelease(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 4 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number), defaultValue (number)").ThrowAsJavaScriptException();
-        return env.Null();
+    if (info.Length() < 2 || !info[1].IsObject()) {
+        Napi::TypeError::New(env, "Expected argument: dbObject (object)").ThrowAsJavaScriptException();
+        return;
     }
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
-        return env.Null();
+    Pool* pool = UnwrapPool(env, info[0]);
+    if (!pool) {
+        return;
     }
-    int row = info[1].As<Napi::Number>();
-    int column = info[2].As<Napi::Number>();
-    int defaultValue = info[3].As<Napi::Number>();
-
-    int result = cubesql_cursor_int(cursor, row, column, defaultValue);
-    return Napi::Number::New(env, result);
+    Napi::Object object = info[1].As<Napi::Object>();
+    if (!object.CheckTypeTag(&kDatabaseTypeTag)) {
+        Napi::TypeError::New(env, "Invalid database object").ThrowAsJavaScriptException();
+        return;
+    }
+    PoolEntry* entry = pool->Find(Database::Unwrap(object)->conn.get());
+    if (!entry || !entry->pinned) {
+        Napi::Error::New(env, "Connection is not checked out from this pool").ThrowAsJavaScriptException();
+        return;
+    }
+    Connection* conn = entry->conn.get();
+    if (conn->busy || conn->activeCursor) {
+        Napi::Error::New(env, "Connection is still in use, wait for its calls and free its cursors before releasing it").ThrowAsJavaScriptException();
+        return;
+    }
+    pool->Release(env, entry, CUBESQL_NOERR);
 }
 
-// Implementation for GetCursorDouble
-Napi::Value GetCursorDouble(const Napi::CallbackInfo& info) {
+// Implementation for PoolExecuteAsync
+Napi::Value PoolExecuteAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 4 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number), defaultValue (number)").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected argument: sql (string)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
+    Pool* pool = UnwrapPool(env, info[0]);
+    if (!pool) {
         return env.Null();
     }
-    int row = info[1].As<Napi::Number>();
-    int column = info[2].As<Napi::Number>();
-    double defaultValue = info[3].As<Napi::Number>();
+    std::string sql = info[1].As<Napi::String>();
 
-    double result = cubesql_cursor_double(cursor, row, column, defaultValue);
-    return Napi::Number::New(env, result);
+    return pool->Run(env, [sql](Napi::Env env, csqldb* db) -> ConnectionWorker* {
+        return new StatusWorker(env, db, [db, sql]() { return cubesql_execute(db, sql.c_str()); });
+    });
 }
 
-// Implementation for GetCursorCString
-Napi::Value GetCursorCString(const Napi::CallbackInfo& info) {
+// Implementation for PoolSelectAsync: the cursor is read completely, so the connection
+// goes back to the pool as soon as the result has arrived
+Napi::Value PoolSelectAsync(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 3 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber()) {
-        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number)").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected argument: sql (string)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
+    Pool* pool = UnwrapPool(env, info[0]);
+    if (!pool) {
         return env.Null();
     }
-    int row = info[1].As<Napi::Number>();
-    int column = info[2].As<Napi::Number>();
-
-    char* result = cubesql_cursor_cstring(cursor, row, column);
-    if (!result) {
+    std::string sql = info[1].As<Napi::String>();
+    int serverSide, prefetch, compression;
+    if (!GetSelectOptions(env, info, 2, &serverSide, &prefetch, &compression)) {
+        return env.Null();
+    }
+    if (serverSide) {
+        Napi::TypeError::New(env, "A server-side cursor holds its connection, read it from a connection checked out with acquire()").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    return Napi::String::New(env, result);
+    return pool->Run(env, [sql, compression](Napi::Env env, csqldb* db) -> ConnectionWorker* {
+        return new CursorWorker(env, db, [db, sql, compression]() { return SelectWithCompression(db, sql, kFALSE, compression); });
+    });
 }
 
-// Implementation for GetCursorCStringStatic
-Napi::Value GetCursorCStringStatic(const Napi::CallbackInfo& info) {
+// Implementation for PoolClose: stops handing out connections and closes the idle ones;
+// checked out connections are closed when they are released
+void PoolClose(const CallArgs& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 4 || !info[0].IsObject() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsBuffer()) {
-        Napi::TypeError::New(env, "Expected arguments: cursorObject (object), row (number), column (number), staticBuffer (Buffer)").ThrowAsJavaScriptException();
-        return env.Null();
+    Pool* pool = UnwrapPool(env, info[0]);
+    if (!pool) {
+        return;
     }
-
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
-        return env.Null();
+    pool->closed = true;
+    pool->StopPruneTimer();
+    while (!pool->waiters.empty()) {
+        Pool::Delivery next = std::move(pool->waiters.front());
+        pool->waiters.pop_front();
+        next(env, nullptr, Napi::Error::New(env, "Pool is closed").Value());
     }
-    int row = info[1].As<Napi::Number>();
-    int column = info[2].As<Napi::Number>();
-    Napi::Buffer<char> staticBuffer = info[3].As<Napi::Buffer<char>>();
+    while (!pool->idle.empty()) {
+        PoolEntry* entry = pool->idle.front();
+        pool->idle.pop_front();
+        pool->Evict(env, entry, true);
+    }
+}
 
-    char* result = cubesql_cursor_cstring_static(cursor, row, column, staticBuffer.Data(), staticBuffer.Length());
-    if (!result) {
+// Implementation for PoolStats
+Napi::Value PoolStats(const CallArgs& info) {
+    Napi::Env env = info.Env();
+
+    Pool* pool = UnwrapPool(env, info[0]);
+    if (!pool) {
         return env.Null();
     }
 
-    return Napi::String::New(env, result);
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("size", Napi::Number::New(env, static_cast<double>(pool->entries.size())));
+    stats.Set("idle", Napi::Number::New(env, static_cast<double>(pool->idle.size())));
+    stats.Set("opening", Napi::Number::New(env, static_cast<double>(pool->opening)));
+    stats.Set("waiting", Napi::Number::New(env, static_cast<double>(pool->waiters.size())));
+    stats.Set("min", Napi::Number::New(env, static_cast<double>(pool->options.min)));
+    stats.Set("max", Napi::Number::New(env, static_cast<double>(pool->options.max)));
+    return stats;
 }
 
-// Implementation for FreeCursor
-void FreeCursor(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
+Napi::Function Pool::Init(Napi::Env env) {
+    return DefineClass(env, "Pool", {
+        InstanceMethod<&Pool::Method<PoolOpen>>("open"),
+        InstanceMethod<&Pool::Method<PoolAcquire>>("acquire"),
+        InstanceMethod<&Pool::Method<PoolRelease>>("release"),
+        InstanceMethod<&Pool::Method<PoolTransaction>>("transaction"),
+        InstanceMethod<&Pool::Method<PoolExecuteAsync>>("executeAsync"),
+        InstanceMethod<&Pool::Method<PoolSelectAsync>>("selectAsync"),
+        InstanceMethod<&Pool::Method<PoolClose>>("close"),
+        InstanceMethod<&Pool::Method<PoolStats>>("stats"),
+    });
+}
 
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected argument: cursorObject (object)").ThrowAsJavaScriptException();
-        return;
-    }
+// MARK: - Database, Cursor and VM classes
 
-    Napi::Object cursorObject = info[0].As<Napi::Object>();
-    csqlc* cursor = cursorObject.Get("cursorPointer").As<Napi::External<csqlc>>().Data();
-    if (!cursor) {
-        Napi::Error::New(env, "Invalid cursor pointer").ThrowAsJavaScriptException();
-        return;
+// Instances are created by the addon only: the constructor takes the native handle as an External,
+// which script code cannot forge
+static bool CheckHandleArgument(const Napi::CallbackInfo& info, const char* className) {
+    if (info.Length() < 1 || !info[0].IsExternal()) {
+        Napi::TypeError::New(info.Env(), std::string(className) + " objects cannot be constructed directly").ThrowAsJavaScriptException();
+        return false;
     }
-    cubesql_cursor_free(cursor);
+    return true;
+}
+
+Database::Database(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Database>(info) {
+    if (!CheckHandleArgument(info, "Database")) return;
+    conn = std::make_shared<Connection>(info[0].As<Napi::External<csqldb>>().Data());
+    info.This().As<Napi::Object>().TypeTag(&kDatabaseTypeTag);
+}
+
+Napi::Function Database::Init(Napi::Env env, AddonData* data) {
+    Napi::Function constructor = DefineClass(env, "Database", {
+        InstanceMethod<&Database::Method<ExecuteSQL>>("execute"),
+        InstanceMethod<&Database::Method<ExecuteEx>>("executeEx"),
+        InstanceMethod<&Database::Method<Pipeline>>("pipeline"),
+        InstanceMethod<&Database::Method<SelectSQL>>("select"),
+        InstanceMethod<&Database::Method<SelectStream>>("selectStream"),
+        InstanceMethod<&Database::Method<CommitTransaction>>("commit"),
+        InstanceMethod<&Database::Method<RollbackTransaction>>("rollback"),
+        InstanceMethod<&Database::Method<BeginTransaction>>("beginTransaction"),
+        InstanceMethod<&Database::Method<BindSQL>>("bind"),
+        InstanceMethod<&Database::Method<PingCubeSQL>>("ping"),
+        InstanceMethod<&Database::Method<CancelCubeSQL>>("cancel"),
+        InstanceMethod<&Database::Method<GetErrorCode>>("errorCode"),
+        InstanceMethod<&Database::Method<GetErrorMessage>>("errorMessage"),
+        InstanceMethod<&Database::Method<GetChanges>>("changes"),
+        InstanceMethod<&Database::Method<SetTraceCallback>>("setTraceCallback"),
+        InstanceMethod<&Database::Method<SetDedicatedThread>>("setDedicatedThread"),
+        InstanceMethod<&Database::Method<SetStatementCache>>("setStatementCache"),
+        InstanceMethod<&Database::Method<GetStatementCacheStats>>("statementCacheStats"),
+        InstanceMethod<&Database::Method<SetCompression>>("setCompression"),
+        InstanceMethod<&Database::Method<GetCompressionStats>>("compressionStats"),
+        InstanceMethod<&Database::Method<SetResultCompression>>("setResultCompression"),
+        InstanceMethod<&Database::Method<SetDatabase>>("setDatabase"),
+        InstanceMethod<&Database::Method<GetAffectedRows>>("affectedRows"),
+        InstanceMethod<&Database::Method<GetLastInsertedRowID>>("lastInsertedRowID"),
+        InstanceMethod<&Database::Method<SendData>>("sendData"),
+        InstanceMethod<&Database::Method<SendEndData>>("sendEndData"),
+        InstanceMethod<&Database::Method<ReceiveData>>("receiveData"),
+        InstanceMethod<&Database::Method<PrepareVM>>("prepare"),
+        InstanceMethod<&Database::Method<DisconnectFromCubeSQL>>("disconnect"),
+        InstanceMethod<&Database::Method<ExecuteAsync>>("executeAsync"),
+        InstanceMethod<&Database::Method<ExecuteExAsync>>("executeExAsync"),
+        InstanceMethod<&Database::Method<PipelineAsync>>("pipelineAsync"),
+        InstanceMethod<&Database::Method<SelectAsync>>("selectAsync"),
+        InstanceMethod<&Database::Method<PrepareAsync>>("prepareAsync"),
+        InstanceMethod<&Database::Method<ExecuteManyAsync>>("executeManyAsync"),
+        InstanceMethod<&Database::Method<SetDatabaseAsync>>("setDatabaseAsync"),
+        InstanceMethod<&Database::Method<DisconnectAsync>>("disconnectAsync"),
+        InstanceMethod<&Database::Method<CommitAsync>>("commitAsync"),
+        InstanceMethod<&Database::Method<RollbackAsync>>("rollbackAsync"),
+        InstanceMethod<&Database::Method<BeginTransactionAsync>>("beginTransactionAsync"),
+        InstanceMethod<&Database::Method<PingAsync>>("pingAsync"),
+        InstanceMethod<&Database::Method<SendEndDataAsync>>("sendEndDataAsync"),
+        InstanceMethod<&Database::Method<GetChangesAsync>>("changesAsync"),
+        InstanceMethod<&Database::Method<GetAffectedRowsAsync>>("affectedRowsAsync"),
+        InstanceMethod<&Database::Method<GetLastInsertedRowIDAsync>>("lastInsertedRowIDAsync"),
+        InstanceMethod<&Database::Method<ReceiveDataAsync>>("receiveDataAsync"),
+        InstanceMethod<&Database::Method<BindAsync>>("bindAsync"),
+        InstanceMethod<&Database::Method<SendDataAsync>>("sendDataAsync"),
+    });
+    data->database = Napi::Persistent(constructor);
+    return constructor;
+}
+
+Napi::Object Database::NewInstance(Napi::Env env, csqldb* db) {
+    AddonData* data = env.GetInstanceData<AddonData>();
+    return data->database.New({Napi::External<csqldb>::New(env, db)});
+}
+
+Cursor::Cursor(const Napi::CallbackInfo& info) : Napi::ObjectWrap<Cursor>(info) {
+    if (!CheckHandleArgument(info, "Cursor")) return;
+    data = std::make_shared<CursorData>(info[0].As<Napi::External<csqlc>>().Data());
+    info.This().As<Napi::Object>().TypeTag(&kCursorTypeTag);
+}
+
+void Cursor::Free() {
+    data.reset();
+}
+
+Napi::Function Cursor::Init(Napi::Env env, AddonData* data) {
+    Napi::Function constructor = DefineClass(env, "Cursor", {
+        InstanceMethod<&Cursor::Method<GetCursorNumRows>>("numRows"),
+        InstanceMethod<&Cursor::Method<GetCursorNumColumns>>("numColumns"),
+        InstanceMethod<&Cursor::Method<GetCursorCurrentRow>>("currentRow"),
+        InstanceMethod<&Cursor::Method<SeekCursor>>("seek"),
+        InstanceMethod<&Cursor::Method<IsCursorEOF>>("isEOF"),
+        InstanceMethod<&Cursor::Method<GetCursorColumnType>>("columnType"),
+        InstanceMethod<&Cursor::Method<GetCursorField>>("field"),
+        InstanceMethod<&Cursor::Method<GetCursorFieldBuffer>>("fieldBuffer"),
+        InstanceMethod<&Cursor::Method<GetCursorRowID>>("rowID"),
+        InstanceMethod<&Cursor::Method<GetCursorInt64>>("int64"),
+        InstanceMethod<&Cursor::Method<GetCursorInt>>("int"),
+        InstanceMethod<&Cursor::Method<GetCursorDouble>>("double"),
+        InstanceMethod<&Cursor::Method<GetCursorCString>>("cstring"),
+        InstanceMethod<&Cursor::Method<GetCursorCStringStatic>>("cstringStatic"),
+        InstanceMethod<&Cursor::Method<FreeCursor>>("free"),
+        InstanceMethod<&Cursor::Method<FetchAll>>("fetchAll"),
+        InstanceMethod<&Cursor::Method<FetchColumns>>("fetchColumns"),
+    });
+    data->cursor = Napi::Persistent(constructor);
+    return constructor;
+}
+
+Napi::Object Cursor::NewInstance(Napi::Env env, csqlc* cursor, std::shared_ptr<Connection> conn) {
+    AddonData* data = env.GetInstanceData<AddonData>();
+    Napi::Object object = data->cursor.New({Napi::External<csqlc>::New(env, cursor)});
+    if (cubesql_cursor_isserverside(cursor)) conn->activeCursor = cursor;
+    Cursor::Unwrap(object)->data->conn = std::move(conn);
+    return object;
+}
+
+VM::VM(const Napi::CallbackInfo& info) : Napi::ObjectWrap<VM>(info) {
+    if (!CheckHandleArgument(info, "VM")) return;
+    vm = info[0].As<Napi::External<csqlvm>>().Data();
+    info.This().As<Napi::Object>().TypeTag(&kVMTypeTag);
+}
+
+// The finalizer runs during garbage collection and must not block on the network, so a VM that
+// was never closed is only released locally; the server drops it with the next prepare or on disconnect
+VM::~VM() {
+    if (!cached) cubesql_vmfree(vm);
+}
+
+Napi::Function VM::Init(Napi::Env env, AddonData* data) {
+    Napi::Function constructor = DefineClass(env, "VM", {
+        InstanceMethod<&VM::Method<BindVMInt>>("bindInt"),
+        InstanceMethod<&VM::Method<BindVMDouble>>("bindDouble"),
+        InstanceMethod<&VM::Method<BindVMText>>("bindText"),
+        InstanceMethod<&VM::Method<BindVM>>("bind"),
+        InstanceMethod<&VM::Method<BindVMNull>>("bindNull"),
+        InstanceMethod<&VM::Method<BindVMInt64>>("bindInt64"),
+        InstanceMethod<&VM::Method<BindVMZeroBlob>>("bindZeroBlob"),
+        InstanceMethod<&VM::Method<ExecuteVM>>("execute"),
+        InstanceMethod<&VM::Method<SelectVM>>("select"),
+        InstanceMethod<&VM::Method<CloseVM>>("close"),
+        InstanceMethod<&VM::Method<BindVMIntAsync>>("bindIntAsync"),
+        InstanceMethod<&VM::Method<BindVMDoubleAsync>>("bindDoubleAsync"),
+        InstanceMethod<&VM::Method<BindVMTextAsync>>("bindTextAsync"),
+        InstanceMethod<&VM::Method<BindVMAsync>>("bindAsync"),
+        InstanceMethod<&VM::Method<BindVMNullAsync>>("bindNullAsync"),
+        InstanceMethod<&VM::Method<BindVMInt64Async>>("bindInt64Async"),
+        InstanceMethod<&VM::Method<BindVMZeroBlobAsync>>("bindZeroBlobAsync"),
+        InstanceMethod<&VM::Method<ExecuteVMAsync>>("executeAsync"),
+        InstanceMethod<&VM::Method<SelectVMAsync>>("selectAsync"),
+        InstanceMethod<&VM::Method<CloseVMAsync>>("closeAsync"),
+        InstanceMethod<&VM::Method<BindExecuteVMAsync>>("bindExecuteAsync"),
+        InstanceMethod<&VM::Method<BindSelectVMAsync>>("bindSelectAsync"),
+        InstanceMethod<&VM::Method<ExecuteManyVMAsync>>("executeManyAsync"),
+    });
+    data->vm = Napi::Persistent(constructor);
+    return constructor;
+}
+
+Napi::Object VM::NewInstance(Napi::Env env, csqlvm* vm, std::shared_ptr<Connection> conn) {
+    AddonData* data = env.GetInstanceData<AddonData>();
+    Napi::Object object = data->vm.New({Napi::External<csqlvm>::New(env, vm)});
+    VM::Unwrap(object)->conn = std::move(conn);
+    return object;
+}
+
+Napi::Object VM::NewInstance(Napi::Env env, std::shared_ptr<CachedStatement> statement, std::shared_ptr<Connection> conn) {
+    Napi::Object object = NewInstance(env, statement->vm, std::move(conn));
+    VM::Unwrap(object)->cached = std::move(statement);
+    return object;
+}
+
+ResultStream::ResultStream(const Napi::CallbackInfo& info) : Napi::ObjectWrap<ResultStream>(info) {
+    if (!CheckHandleArgument(info, "ResultStream")) return;
+    info.This().As<Napi::Object>().TypeTag(&kStreamTypeTag);
+}
+
+Napi::Function ResultStream::Init(Napi::Env env, AddonData* data) {
+    Napi::Function constructor = DefineClass(env, "ResultStream", {
+        InstanceMethod<&ResultStream::Method<StreamNext>>("next"),
+        InstanceMethod<&ResultStream::Method<StreamReturn>>("return"),
+        InstanceMethod<&ResultStream::Method<StreamIterator>>(Napi::Symbol::WellKnown(env, "asyncIterator")),
+    });
+    data->stream = Napi::Persistent(constructor);
+    return constructor;
+}
+
+Napi::Object ResultStream::NewInstance(Napi::Env env, std::shared_ptr<Connection> conn, std::string sql, bool asObjects) {
+    AddonData* data = env.GetInstanceData<AddonData>();
+    Napi::Object object = data->stream.New({Napi::External<void>::New(env, nullptr)});
+    ResultStream* stream = ResultStream::Unwrap(object);
+    stream->conn = std::move(conn);
+    stream->sql = std::move(sql);
+    stream->asObjects = asObjects;
+    return object;
 }
 
 // Initialize the addon
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
-    exports.Set(Napi::String::New(env, "getCubeSQLVersion"), Napi::Function::New(env, GetCubeSQLVersion));
-    exports.Set(Napi::String::New(env, "connectToCubeSQL"), Napi::Function::New(env, ConnectToCubeSQL));
-    exports.Set(Napi::String::New(env, "connectToCubeSQLSSL"), Napi::Function::New(env, ConnectToCubeSQLSSL));
-    exports.Set(Napi::String::New(env, "disconnectFromCubeSQL"), Napi::Function::New(env, DisconnectFromCubeSQL));
-    exports.Set(Napi::String::New(env, "executeSQL"), Napi::Function::New(env, ExecuteSQL));
-    exports.Set(Napi::String::New(env, "selectSQL"), Napi::Function::New(env, SelectSQL));
-    exports.Set(Napi::String::New(env, "commitTransaction"), Napi::Function::New(env, CommitTransaction));
-    exports.Set(Napi::String::New(env, "rollbackTransaction"), Napi::Function::New(env, RollbackTransaction));
-    exports.Set(Napi::String::New(env, "beginTransaction"), Napi::Function::New(env, BeginTransaction));
-    exports.Set(Napi::String::New(env, "bindSQL"), Napi::Function::New(env, BindSQL));
-    exports.Set(Napi::String::New(env, "pingCubeSQL"), Napi::Function::New(env, PingCubeSQL));
-    exports.Set(Napi::String::New(env, "cancelCubeSQL"), Napi::Function::New(env, CancelCubeSQL));
-    exports.Set(Napi::String::New(env, "getErrorCode"), Napi::Function::New(env, GetErrorCode));
-    exports.Set(Napi::String::New(env, "getErrorMessage"), Napi::Function::New(env, GetErrorMessage));
-    exports.Set(Napi::String::New(env, "getChanges"), Napi::Function::New(env, GetChanges));
-    exports.Set(Napi::String::New(env, "setTraceCallback"), Napi::Function::New(env, SetTraceCallback));
-    exports.Set(Napi::String::New(env, "setDatabase"), Napi::Function::New(env, SetDatabase));
-    exports.Set(Napi::String::New(env, "getAffectedRows"), Napi::Function::New(env, GetAffectedRows));
-    exports.Set(Napi::String::New(env, "getLastInsertedRowID"), Napi::Function::New(env, GetLastInsertedRowID));
-    exports.Set(Napi::String::New(env, "sleepMilliseconds"), Napi::Function::New(env, SleepMilliseconds));
-    exports.Set(Napi::String::New(env, "sendData"), Napi::Function::New(env, SendData));
-    exports.Set(Napi::String::New(env, "sendEndData"), Napi::Function::New(env, SendEndData));
-    exports.Set(Napi::String::New(env, "receiveData"), Napi::Function::New(env, ReceiveData));
-    exports.Set(Napi::String::New(env, "prepareVM"), Napi::Function::New(env, PrepareVM));
-    exports.Set(Napi::String::New(env, "bindVMInt"), Napi::Function::New(env, BindVMInt));
-    exports.Set(Napi::String::New(env, "bindVMDouble"), Napi::Function::New(env, BindVMDouble));
-    exports.Set(Napi::String::New(env, "bindVMText"), Napi::Function::New(env, BindVMText));
-    exports.Set(Napi::String::New(env, "bindVMNull"), Napi::Function::New(env, BindVMNull));
-    exports.Set(Napi::String::New(env, "bindVMInt64"), Napi::Function::New(env, BindVMInt64));
-    exports.Set(Napi::String::New(env, "bindVMZeroBlob"), Napi::Function::New(env, BindVMZeroBlob));
-    exports.Set(Napi::String::New(env, "executeVM"), Napi::Function::New(env, ExecuteVM));
-    exports.Set(Napi::String::New(env, "selectVM"), Napi::Function::New(env, SelectVM));
-    exports.Set(Napi::String::New(env, "closeVM"), Napi::Function::New(env, CloseVM));
-    exports.Set(Napi::String::New(env, "getCursorNumRows"), Napi::Function::New(env, GetCursorNumRows));
-    exports.Set(Napi::String::New(env, "getCursorNumColumns"), Napi::Function::New(env, GetCursorNumColumns));
-    exports.Set(Napi::String::New(env, "getCursorCurrentRow"), Napi::Function::New(env, GetCursorCurrentRow));
-    exports.Set(Napi::String::New(env, "seekCursor"), Napi::Function::New(env, SeekCursor));
-    exports.Set(Napi::String::New(env, "isCursorEOF"), Napi::Function::New(env, IsCursorEOF));
-    exports.Set(Napi::String::New(env, "getCursorColumnType"), Napi::Function::New(env, GetCursorColumnType));
-    exports.Set(Napi::String::New(env, "getCursorField"), Napi::Function::New(env, GetCursorField));
-    exports.Set(Napi::String::New(env, "getCursorFieldBuffer"), Napi::Function::New(env, GetCursorFieldBuffer));
-    exports.Set(Napi::String::New(env, "getCursorRowID"), Napi::Function::New(env, GetCursorRowID));
-    exports.Set(Napi::String::New(env, "getCursorInt64"), Napi::Function::New(env, GetCursorInt64));
-    exports.Set(Napi::String::New(env, "getCursorInt"), Napi::Function::New(env, GetCursorInt));
-    exports.Set(Napi::String::New(env, "getCursorDouble"), Napi::Function::New(env, GetCursorDouble));
-    exports.Set(Napi::String::New(env, "getCursorCString"), Napi::Function::New(env, GetCursorCString));
-    exports.Set(Napi::String::New(env, "getCursorCStringStatic"), Napi::Function::New(env, GetCursorCStringStatic));
-    exports.Set(Napi::String::New(env, "freeCursor"), Napi::Function::New(env, FreeCursor));
+    AddonData* data = new AddonData();
+    env.SetInstanceData(data);
+    exports.Set(Napi::String::New(env, "Database"), Database::Init(env, data));
+    exports.Set(Napi::String::New(env, "Cursor"), Cursor::Init(env, data));
+    exports.Set(Napi::String::New(env, "VM"), VM::Init(env, data));
+    exports.Set(Napi::String::New(env, "ResultStream"), ResultStream::Init(env, data));
+    exports.Set(Napi::String::New(env, "Pool"), Pool::Init(env));
+
+    exports.Set(Napi::String::New(env, "getCubeSQLVersion"), Napi::Function::New(env, Export<GetCubeSQLVersion>));
+    exports.Set(Napi::String::New(env, "connectToCubeSQL"), Napi::Function::New(env, Export<ConnectToCubeSQL>));
+    exports.Set(Napi::String::New(env, "connectToCubeSQLSSL"), Napi::Function::New(env, Export<ConnectToCubeSQLSSL>));
+    exports.Set(Napi::String::New(env, "disconnectFromCubeSQL"), Napi::Function::New(env, Export<DisconnectFromCubeSQL>));
+    exports.Set(Napi::String::New(env, "executeSQL"), Napi::Function::New(env, Export<ExecuteSQL>));
+    exports.Set(Napi::String::New(env, "executeEx"), Napi::Function::New(env, Export<ExecuteEx>));
+    exports.Set(Napi::String::New(env, "pipeline"), Napi::Function::New(env, Export<Pipeline>));
+    exports.Set(Napi::String::New(env, "selectSQL"), Napi::Function::New(env, Export<SelectSQL>));
+    exports.Set(Napi::String::New(env, "commitTransaction"), Napi::Function::New(env, Export<CommitTransaction>));
+    exports.Set(Napi::String::New(env, "rollbackTransaction"), Napi::Function::New(env, Export<RollbackTransaction>));
+    exports.Set(Napi::String::New(env, "beginTransaction"), Napi::Function::New(env, Export<BeginTransaction>));
+    exports.Set(Napi::String::New(env, "bindSQL"), Napi::Function::New(env, Export<BindSQL>));
+    exports.Set(Napi::String::New(env, "pingCubeSQL"), Napi::Function::New(env, Export<PingCubeSQL>));
+    exports.Set(Napi::String::New(env, "cancelCubeSQL"), Napi::Function::New(env, Export<CancelCubeSQL>));
+    exports.Set(Napi::String::New(env, "getErrorCode"), Napi::Function::New(env, Export<GetErrorCode>));
+    exports.Set(Napi::String::New(env, "getErrorMessage"), Napi::Function::New(env, Export<GetErrorMessage>));
+    exports.Set(Napi::String::New(env, "getChanges"), Napi::Function::New(env, Export<GetChanges>));
+    exports.Set(Napi::String::New(env, "setTraceCallback"), Napi::Function::New(env, Export<SetTraceCallback>));
+    exports.Set(Napi::String::New(env, "setDedicatedThread"), Napi::Function::New(env, Export<SetDedicatedThread>));
+    exports.Set(Napi::String::New(env, "setStatementCache"), Napi::Function::New(env, Export<SetStatementCache>));
+    exports.Set(Napi::String::New(env, "getStatementCacheStats"), Napi::Function::New(env, Export<GetStatementCacheStats>));
+    exports.Set(Napi::String::New(env, "setCompression"), Napi::Function::New(env, Export<SetCompression>));
+    exports.Set(Napi::String::New(env, "getCompressionStats"), Napi::Function::New(env, Export<GetCompressionStats>));
+    exports.Set(Napi::String::New(env, "setResultCompression"), Napi::Function::New(env, Export<SetResultCompression>));
+    exports.Set(Napi::String::New(env, "setDatabase"), Napi::Function::New(env, Export<SetDatabase>));
+    exports.Set(Napi::String::New(env, "getAffectedRows"), Napi::Function::New(env, Export<GetAffectedRows>));
+    exports.Set(Napi::String::New(env, "getLastInsertedRowID"), Napi::Function::New(env, Export<GetLastInsertedRowID>));
+    exports.Set(Napi::String::New(env, "sleepMilliseconds"), Napi::Function::New(env, Export<SleepMilliseconds>));
+    exports.Set(Napi::String::New(env, "sendData"), Napi::Function::New(env, Export<SendData>));
+    exports.Set(Napi::String::New(env, "sendEndData"), Napi::Function::New(env, Export<SendEndData>));
+    exports.Set(Napi::String::New(env, "receiveData"), Napi::Function::New(env, Export<ReceiveData>));
+    exports.Set(Napi::String::New(env, "prepareVM"), Napi::Function::New(env, Export<PrepareVM>));
+    exports.Set(Napi::String::New(env, "bindVMInt"), Napi::Function::New(env, Export<BindVMInt>));
+    exports.Set(Napi::String::New(env, "bindVMDouble"), Napi::Function::New(env, Export<BindVMDouble>));
+    exports.Set(Napi::String::New(env, "bindVMText"), Napi::Function::New(env, Export<BindVMText>));
+    exports.Set(Napi::String::New(env, "bindVM"), Napi::Function::New(env, Export<BindVM>));
+    exports.Set(Napi::String::New(env, "bindVMNull"), Napi::Function::New(env, Export<BindVMNull>));
+    exports.Set(Napi::String::New(env, "bindVMInt64"), Napi::Function::New(env, Export<BindVMInt64>));
+    exports.Set(Napi::String::New(env, "bindVMZeroBlob"), Napi::Function::New(env, Export<BindVMZeroBlob>));
+    exports.Set(Napi::String::New(env, "executeVM"), Napi::Function::New(env, Export<ExecuteVM>));
+    exports.Set(Napi::String::New(env, "selectVM"), Napi::Function::New(env, Export<SelectVM>));
+    exports.Set(Napi::String::New(env, "closeVM"), Napi::Function::New(env, Export<CloseVM>));
+    exports.Set(Napi::String::New(env, "getCursorNumRows"), Napi::Function::New(env, Export<GetCursorNumRows>));
+    exports.Set(Napi::String::New(env, "getCursorNumColumns"), Napi::Function::New(env, Export<GetCursorNumColumns>));
+    exports.Set(Napi::String::New(env, "getCursorCurrentRow"), Napi::Function::New(env, Export<GetCursorCurrentRow>));
+    exports.Set(Napi::String::New(env, "seekCursor"), Napi::Function::New(env, Export<SeekCursor>));
+    exports.Set(Napi::String::New(env, "isCursorEOF"), Napi::Function::New(env, Export<IsCursorEOF>));
+    exports.Set(Napi::String::New(env, "getCursorColumnType"), Napi::Function::New(env, Export<GetCursorColumnType>));
+    exports.Set(Napi::String::New(env, "getCursorField"), Napi::Function::New(env, Export<GetCursorField>));
+    exports.Set(Napi::String::New(env, "getCursorFieldBuffer"), Napi::Function::New(env, Export<GetCursorFieldBuffer>));
+    exports.Set(Napi::String::New(env, "getCursorRowID"), Napi::Function::New(env, Export<GetCursorRowID>));
+    exports.Set(Napi::String::New(env, "getCursorInt64"), Napi::Function::New(env, Export<GetCursorInt64>));
+    exports.Set(Napi::String::New(env, "getCursorInt"), Napi::Function::New(env, Export<GetCursorInt>));
+    exports.Set(Napi::String::New(env, "getCursorDouble"), Napi::Function::New(env, Export<GetCursorDouble>));
+    exports.Set(Napi::String::New(env, "getCursorCString"), Napi::Function::New(env, Export<GetCursorCString>));
+    exports.Set(Napi::String::New(env, "getCursorCStringStatic"), Napi::Function::New(env, Export<GetCursorCStringStatic>));
+    exports.Set(Napi::String::New(env, "freeCursor"), Napi::Function::New(env, Export<FreeCursor>));
+    exports.Set(Napi::String::New(env, "fetchAll"), Napi::Function::New(env, Export<FetchAll>));
+    exports.Set(Napi::String::New(env, "fetchColumns"), Napi::Function::New(env, Export<FetchColumns>));
+    exports.Set(Napi::String::New(env, "selectStream"), Napi::Function::New(env, Export<SelectStream>));
+
+    // Promise-based variants that run the network round trip on a worker thread
+    exports.Set(Napi::String::New(env, "connectAsync"), Napi::Function::New(env, Export<ConnectAsync>));
+    exports.Set(Napi::String::New(env, "connectSSLAsync"), Napi::Function::New(env, Export<ConnectSSLAsync>));
+    exports.Set(Napi::String::New(env, "executeAsync"), Napi::Function::New(env, Export<ExecuteAsync>));
+    exports.Set(Napi::String::New(env, "executeExAsync"), Napi::Function::New(env, Export<ExecuteExAsync>));
+    exports.Set(Napi::String::New(env, "pipelineAsync"), Napi::Function::New(env, Export<PipelineAsync>));
+    exports.Set(Napi::String::New(env, "selectAsync"), Napi::Function::New(env, Export<SelectAsync>));
+    exports.Set(Napi::String::New(env, "prepareAsync"), Napi::Function::New(env, Export<PrepareAsync>));
+    exports.Set(Napi::String::New(env, "executeManyAsync"), Napi::Function::New(env, Export<ExecuteManyAsync>));
+    exports.Set(Napi::String::New(env, "setDatabaseAsync"), Napi::Function::New(env, Export<SetDatabaseAsync>));
+    exports.Set(Napi::String::New(env, "disconnectAsync"), Napi::Function::New(env, Export<DisconnectAsync>));
+    exports.Set(Napi::String::New(env, "commitAsync"), Napi::Function::New(env, Export<CommitAsync>));
+    exports.Set(Napi::String::New(env, "rollbackAsync"), Napi::Function::New(env, Export<RollbackAsync>));
+    exports.Set(Napi::String::New(env, "beginTransactionAsync"), Napi::Function::New(env, Export<BeginTransactionAsync>));
+    exports.Set(Napi::String::New(env, "pingAsync"), Napi::Function::New(env, Export<PingAsync>));
+    exports.Set(Napi::String::New(env, "sendEndDataAsync"), Napi::Function::New(env, Export<SendEndDataAsync>));
+    exports.Set(Napi::String::New(env, "getChangesAsync"), Napi::Function::New(env, Export<GetChangesAsync>));
+    exports.Set(Napi::String::New(env, "getAffectedRowsAsync"), Napi::Function::New(env, Export<GetAffectedRowsAsync>));
+    exports.Set(Napi::String::New(env, "getLastInsertedRowIDAsync"), Napi::Function::New(env, Export<GetLastInsertedRowIDAsync>));
+    exports.Set(Napi::String::New(env, "receiveDataAsync"), Napi::Function::New(env, Export<ReceiveDataAsync>));
+    exports.Set(Napi::String::New(env, "bindAsync"), Napi::Function::New(env, Export<BindAsync>));
+    exports.Set(Napi::String::New(env, "sendDataAsync"), Napi::Function::New(env, Export<SendDataAsync>));
+    exports.Set(Napi::String::New(env, "bindVMIntAsync"), Napi::Function::New(env, Export<BindVMIntAsync>));
+    exports.Set(Napi::String::New(env, "bindVMDoubleAsync"), Napi::Function::New(env, Export<BindVMDoubleAsync>));
+    exports.Set(Napi::String::New(env, "bindVMTextAsync"), Napi::Function::New(env, Export<BindVMTextAsync>));
+    exports.Set(Napi::String::New(env, "bindVMAsync"), Napi::Function::New(env, Export<BindVMAsync>));
+    exports.Set(Napi::String::New(env, "bindVMNullAsync"), Napi::Function::New(env, Export<BindVMNullAsync>));
+    exports.Set(Napi::String::New(env, "bindVMInt64Async"), Napi::Function::New(env, Export<BindVMInt64Async>));
+    exports.Set(Napi::String::New(env, "bindVMZeroBlobAsync"), Napi::Function::New(env, Export<BindVMZeroBlobAsync>));
+    exports.Set(Napi::String::New(env, "executeVMAsync"), Napi::Function::New(env, Export<ExecuteVMAsync>));
+    exports.Set(Napi::String::New(env, "selectVMAsync"), Napi::Function::New(env, Export<SelectVMAsync>));
+    exports.Set(Napi::String::New(env, "closeVMAsync"), Napi::Function::New(env, Export<CloseVMAsync>));
+    exports.Set(Napi::String::New(env, "bindExecuteVMAsync"), Napi::Function::New(env, Export<BindExecuteVMAsync>));
+    exports.Set(Napi::String::New(env, "bindSelectVMAsync"), Napi::Function::New(env, Export<BindSelectVMAsync>));
+    exports.Set(Napi::String::New(env, "executeManyVMAsync"), Napi::Function::New(env, Export<ExecuteManyVMAsync>));
 
     // Export all constants from CubeSQL-SDK
     exports.Set(Napi::String::New(env, "CUBESQL_ENCRYPTION_NONE"), Napi::Number::New(env, CUBESQL_ENCRYPTION_NONE));
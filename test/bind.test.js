@@ -0,0 +1,97 @@
+import { describe, test, before, after, beforeEach } from 'node:test';
+import assert from 'node:assert/strict';
+import { connect, skip, tableName } from './server.js';
+
+describe('bind type conversion', { skip }, () => {
+    const table = tableName('bind');
+    const insert = `INSERT INTO ${table} (id, i, f, t, b) VALUES (?1, ?2, ?3, ?4, ?5)`;
+    let db;
+
+    function row(id) {
+        const cursor = db.select(`SELECT i, f, t, b FROM ${table} WHERE id = ${id}`);
+        const [fields] = cursor.fetchAll();
+        cursor.free();
+        return fields;
+    }
+
+    function integers() {
+        const cursor = db.select(`SELECT i FROM ${table} ORDER BY id`);
+        const [column] = cursor.fetchColumns([1]);
+        cursor.free();
+        return [...column.values];
+    }
+
+    before(async () => {
+        db = await connect();
+        await db.executeAsync(`CREATE TABLE ${table} (id INTEGER PRIMARY KEY, i INTEGER, f FLOAT, t TEXT, b BLOB)`);
+    });
+
+    beforeEach(async () => {
+        await db.executeAsync(`DELETE FROM ${table}`);
+    });
+
+    after(async () => {
+        if (!db) return;
+        await db.executeAsync(`DROP TABLE ${table}`);
+        await db.disconnectAsync();
+    });
+
+    test('binds numbers, booleans, strings, blobs and null', () => {
+        db.bind(insert, [1, 42, 0.25, 'text', Buffer.from('blob')]);
+        db.bind(insert, [2, true, -1e300, '', new Uint8Array([0, 255])]);
+        db.bind(insert, [3, null, undefined, null, new ArrayBuffer(0)]);
+
+        const first = row(1);
+        assert.deepEqual(first.slice(0, 3), ['42', '0.25', 'text']);
+        assert.equal(first[3].toString(), 'blob');
+        const second = row(2);
+        assert.equal(second[0], '1');
+        assert.equal(Number(second[1]), -1e300);
+        assert.deepEqual([...second[3]], [0, 255]);
+        assert.deepEqual(row(3).slice(0, 3), [null, null, null]);
+    });
+
+    test('binds NaN as NULL', async () => {
+        db.bind(insert, [1, NaN, NaN, 'a', null]);
+        const vm = db.prepare(insert);
+        vm.bind(1, 2);
+        vm.bind(2, NaN);
+        vm.bind(3, NaN);
+        vm.bind(4, 'b');
+        vm.bind(5, null);
+        vm.execute();
+        vm.close();
+        await db.executeManyAsync(insert, { id: [3], i: new Float64Array([NaN]), f: new Float32Array([NaN]), t: ['c'], b: [null] });
+
+        for (const id of [1, 2, 3]) {
+            assert.deepEqual(row(id).slice(0, 2), [null, null]);
+        }
+    });
+
+    test('rejects Infinity', async () => {
+        assert.throws(() => db.bind(insert, [1, Infinity, 0, 'a', null]), { name: 'TypeError', message: /Parameter 2/ });
+        assert.throws(() => db.bind(insert, [1, 0, -Infinity, 'a', null]), { name: 'TypeError', message: /Parameter 3/ });
+        const vm = db.prepare(insert);
+        assert.throws(() => vm.bind(3, Infinity), TypeError);
+        vm.close();
+        await assert.rejects(async () => db.executeManyAsync(insert, [[1, 0, 0, 'a', null], [2, 0, Infinity, 'b', null]]),
+                             { name: 'TypeError', message: /Row 1, parameter 3/ });
+        assert.equal(integers().length, 0);
+    });
+
+    test('binds bigints within 64 bits and rejects the others', () => {
+        const max = 2n ** 63n - 1n;
+        const min = -(2n ** 63n);
+        db.bind(insert, [1, max, 0, 'max', null]);
+        db.bind(insert, [2, min, 0, 'min', null]);
+        db.bind(insert, [3, 2 ** 53, 0, 'number', null]);
+        assert.deepEqual(integers(), [max, min, 2n ** 53n]);
+
+        assert.throws(() => db.bind(insert, [4, max + 1n, 0, 'a', null]), RangeError);
+        assert.throws(() => db.bind(insert, [4, min - 1n, 0, 'a', null]), RangeError);
+        const vm = db.prepare(insert);
+        assert.throws(() => vm.bind(2, 2n ** 64n), RangeError);
+        vm.close();
+        assert.equal(integers().length, 3);
+    });
+});
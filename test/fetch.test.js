@@ -0,0 +1,77 @@
+import { describe, test, before, after } from 'node:test';
+import assert from 'node:assert/strict';
+import { cubesql, connect, skip, tableName } from './server.js';
+
+describe('fetchAll and fetchColumns', { skip }, () => {
+    const table = tableName('fetch');
+    let db;
+
+    before(async () => {
+        db = await connect();
+        await db.executeAsync(`CREATE TABLE ${table} (id INTEGER PRIMARY KEY, name TEXT, price FLOAT, data BLOB)`);
+        db.bind(`INSERT INTO ${table} (id, name, price, data) VALUES (?1, ?2, ?3, ?4)`, [1, 'one', 1.5, Buffer.from([1, 2, 3])]);
+        db.bind(`INSERT INTO ${table} (id, name, price, data) VALUES (?1, ?2, ?3, ?4)`, [2, null, null, null]);
+        db.bind(`INSERT INTO ${table} (id, name, price, data) VALUES (?1, ?2, ?3, ?4)`, [3, 'three', -2.25, Buffer.alloc(0)]);
+    });
+
+    after(async () => {
+        if (!db) return;
+        await db.executeAsync(`DROP TABLE ${table}`);
+        await db.disconnectAsync();
+    });
+
+    test('returns rows as arrays by default', () => {
+        const cursor = db.select(`SELECT id, name, price, data FROM ${table} ORDER BY id`);
+        const rows = cursor.fetchAll();
+        cursor.free();
+
+        assert.equal(rows.length, 3);
+        assert.deepEqual(rows[0].slice(0, 3), ['1', 'one', '1.5']);
+        assert.ok(Buffer.isBuffer(rows[0][3]));
+        assert.deepEqual([...rows[0][3]], [1, 2, 3]);
+        assert.deepEqual(rows[1], ['2', null, null, null]);
+        assert.equal(rows[2][3].length, 0);
+    });
+
+    test('returns rows as objects keyed by column name', () => {
+        const cursor = db.select(`SELECT id, name FROM ${table} ORDER BY id`);
+        const rows = cubesql.fetchAll(cursor, { shape: 'objects' });
+        cursor.free();
+
+        assert.deepEqual(rows, [{ id: '1', name: 'one' }, { id: '2', name: null }, { id: '3', name: 'three' }]);
+    });
+
+    test('rejects an unknown shape', () => {
+        const cursor = db.select(`SELECT id FROM ${table}`);
+        assert.throws(() => cursor.fetchAll({ shape: 'rows' }), TypeError);
+        cursor.free();
+    });
+
+    test('rejects server-side cursors', () => {
+        const cursor = db.select(`SELECT id FROM ${table}`, { serverSide: true });
+        assert.throws(() => cursor.fetchAll(), /server side cursors/);
+        assert.throws(() => cursor.fetchColumns([1]), /server side cursors/);
+        cursor.free();
+    });
+
+    test('extracts numeric columns into typed arrays with a nulls bitmap', () => {
+        const cursor = db.select(`SELECT id, price FROM ${table} ORDER BY id`);
+        const [ids, prices] = cursor.fetchColumns([1, 2]);
+        cursor.free();
+
+        assert.ok(ids.values instanceof BigInt64Array);
+        assert.deepEqual([...ids.values], [1n, 2n, 3n]);
+        assert.deepEqual([...ids.nulls], [0]);
+        assert.ok(prices.values instanceof Float64Array);
+        assert.deepEqual([...prices.values], [1.5, 0, -2.25]);
+        assert.deepEqual([...prices.nulls], [0b010]);
+    });
+
+    test('rejects text columns and invalid indexes', () => {
+        const cursor = db.select(`SELECT id, name FROM ${table}`);
+        assert.throws(() => cursor.fetchColumns([2]), TypeError);
+        assert.throws(() => cursor.fetchColumns([0]), RangeError);
+        assert.throws(() => cursor.fetchColumns([3]), RangeError);
+        cursor.free();
+    });
+});
@@ -0,0 +1,110 @@
+/*
+ Checks the text to number kernels used by fetchColumns (csql_parse_int64 and
+ csql_parse_double in cubesql.c) against strtoll and strtod, which is what
+ cubesql_cursor_int64 and cubesql_cursor_double return for the same field.
+ Doubles are compared bit for bit, so -0 and NaN have to match as well.
+
+ Run by npm test, or build it from the repository root with:
+
+ cc -O2 -DCUBESQL_DISABLE_SSL_ENCRYPTION -ICubeSQL-SDK/C_SDK -ICubeSQL-SDK/C_SDK/crypt -o build/parse test/parse.c \
+    CubeSQL-SDK/C_SDK/cubesql.c CubeSQL-SDK/C_SDK/crypt/aescrypt.c CubeSQL-SDK/C_SDK/crypt/aeskey.c \
+    CubeSQL-SDK/C_SDK/crypt/aesni.c CubeSQL-SDK/C_SDK/crypt/aestab.c CubeSQL-SDK/C_SDK/crypt/base64.c \
+    CubeSQL-SDK/C_SDK/crypt/pseudorandom.c CubeSQL-SDK/C_SDK/crypt/sha1.c -lz
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cubesql.h"
+#include "csql.h"
+
+static const char *cases[] = {
+	// plain values and signs
+	"0", "-0", "+0", "7", "-7", "+7", "42", "-42", "12345678", "123456789", "-1234567812345678",
+	// 18 digits take the fast path, 19 digits and more go through strtoll
+	"999999999999999999", "-999999999999999999", "1000000000000000000",
+	"9223372036854775807", "-9223372036854775807", "-9223372036854775808",
+	"9223372036854775808", "-9223372036854775809", "18446744073709551616", "99999999999999999999",
+	// a leading zero makes strtoll read octal
+	"00", "010", "-010", "+010", "08", "0777", "012345678", "000000000000000000001",
+	// hex, blanks and text
+	"0x1F", "-0x10", "0X7fffffffffffffff", " 12", "12 ", "1 2", "", "-", "+", "abc", "12abc", "--1",
+	// decimals
+	"0.0", "-0.0", "0.5", "-0.5", ".5", "5.", "-.5", "1.25", "3.14159", "0.1", "0.3", "123456.789", "-0.000001",
+	// exponents, within and beyond the exact powers of ten
+	"1e0", "1E5", "1e+5", "1e-5", "2.5e22", "2.5e-22", "1e22", "1e-22", "1e23", "1e-23",
+	"8.9e-30", "1.5e300", "-1.5e-300", "1e308", "1e309", "4.9e-324", "1e-400", "1e", "1e+", "1e-", "1e00001",
+	"123456789e-30", "9007199254740993", "9007199254740992e3", "0.00000000000000000000000000001",
+	// more than 19 significant digits
+	"12345678901234567890", "1234567890123456789.5", "12345678901234567890.5", "0.12345678901234567890123",
+	"0.00000000000000000000012345678901234567890123", "1.0000000000000000000000000001", "100000000000000000000000",
+	// special values
+	"nan", "NaN", "-nan", "inf", "-inf", "Infinity",
+	NULL
+};
+
+static int failures = 0;
+
+static void check (const char *field, int len) {
+	char		buf[64];
+	long long	expected_int, parsed_int;
+	double		expected_double, parsed_double;
+
+	memcpy(buf, field, len);
+	buf[len] = 0;
+
+	expected_int = strtoll(buf, NULL, 0);
+	parsed_int = csql_parse_int64(field, len);
+	if (parsed_int != expected_int) {
+		printf("csql_parse_int64(\"%s\") = %lld, strtoll = %lld\n", buf, parsed_int, expected_int);
+		++failures;
+	}
+
+	expected_double = strtod(buf, NULL);
+	parsed_double = csql_parse_double(field, len);
+	if (memcmp(&parsed_double, &expected_double, sizeof(double)) != 0) {
+		printf("csql_parse_double(\"%s\") = %.17g, strtod = %.17g\n", buf, parsed_double, expected_double);
+		++failures;
+	}
+}
+
+// a random decimal: sign, up to 25 digits with or without a point, and an exponent up to 35
+static int random_number (char *buf) {
+	int	i, n = 0, ndigits = 1 + rand() % 25, point = rand() % (ndigits + 2) - 1;
+
+	if (rand() % 3 == 0) buf[n++] = (rand() % 2) ? '-' : '+';
+	for (i=0; i<ndigits; i++) {
+		if (i == point) buf[n++] = '.';
+		buf[n++] = (char)('0' + ((i == 0 && rand() % 4) ? 1 + rand() % 9 : rand() % 10));
+	}
+	if (rand() % 3 == 0) n += sprintf(buf + n, "e%d", rand() % 71 - 35);
+	return n;
+}
+
+int main (void) {
+	char	field[64];
+	int		i, len;
+
+	for (i=0; cases[i]; i++) {
+		len = (int)strlen(cases[i]);
+
+		// the fields of a chunk are not NUL terminated, let a digit follow to catch reads past the end
+		memcpy(field, cases[i], len);
+		field[len] = '9';
+		check(field, len);
+	}
+
+	srand(1);
+	for (i=0; i<1000000; i++) {
+		len = random_number(field);
+		field[len] = '9';
+		check(field, len);
+	}
+
+	if (failures) {
+		printf("%d mismatches\n", failures);
+		return 1;
+	}
+	printf("csql_parse_int64 and csql_parse_double match strtoll and strtod\n");
+	return 0;
+}
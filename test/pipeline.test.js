@@ -0,0 +1,84 @@
+import { describe, test, before, after, beforeEach } from 'node:test';
+import assert from 'node:assert/strict';
+import { connect, skip, tableName } from './server.js';
+
+describe('pipeline', { skip }, () => {
+    const table = tableName('pipeline');
+    let db;
+
+    function count() {
+        const cursor = db.select(`SELECT COUNT(*) FROM ${table}`);
+        const [[n]] = cursor.fetchAll();
+        cursor.free();
+        return Number(n);
+    }
+
+    before(async () => {
+        db = await connect();
+        await db.executeAsync(`CREATE TABLE ${table} (id INTEGER PRIMARY KEY, name TEXT)`);
+    });
+
+    beforeEach(async () => {
+        await db.executeAsync(`DELETE FROM ${table}`);
+    });
+
+    after(async () => {
+        if (!db) return;
+        await db.executeAsync(`DROP TABLE ${table}`);
+        await db.disconnectAsync();
+    });
+
+    test('returns one result per statement and keeps going after a failure', () => {
+        const results = db.pipeline([
+            `INSERT INTO ${table} (id, name) VALUES (1, 'a')`,
+            `INSERT INTO missing_${table} (id) VALUES (1)`,
+            `INSERT INTO ${table} (id, name) VALUES (2, 'b')`,
+            { sql: `SELECT name FROM ${table} ORDER BY id`, select: true },
+        ]);
+
+        assert.equal(results.length, 4);
+        assert.equal(results[0].rc, 0);
+        assert.equal(results[0].message, undefined);
+        assert.notEqual(results[1].rc, 0);
+        assert.equal(typeof results[1].message, 'string');
+        assert.equal(results[2].rc, 0);
+        assert.equal(results[3].rc, 0);
+        assert.deepEqual(results[3].cursor.fetchAll(), [['a'], ['b']]);
+        results[3].cursor.free();
+    });
+
+    test('maps a failed select to its result without a cursor', () => {
+        const results = db.pipeline([{ sql: `SELECT * FROM missing_${table}`, select: true }, 'SELECT 1']);
+
+        assert.notEqual(results[0].rc, 0);
+        assert.equal(typeof results[0].message, 'string');
+        assert.equal(results[0].cursor, undefined);
+        assert.equal(results[1].rc, 0);
+    });
+
+    test('rolls a transaction back and rejects with the failed statement', async () => {
+        await assert.rejects(db.pipelineAsync([
+            `INSERT INTO ${table} (id, name) VALUES (1, 'a')`,
+            `INSERT INTO ${table} (id, name) VALUES (1, 'duplicate')`,
+            `INSERT INTO ${table} (id, name) VALUES (2, 'b')`,
+        ], { transaction: true }), (error) => {
+            assert.equal(error.statement, 1);
+            assert.equal(typeof error.code, 'number');
+            assert.notEqual(error.code, 0);
+            return true;
+        });
+        assert.equal(count(), 0);
+
+        const results = await db.pipelineAsync([
+            `INSERT INTO ${table} (id, name) VALUES (1, 'a')`,
+            `INSERT INTO ${table} (id, name) VALUES (2, 'b')`,
+        ], { transaction: true });
+        assert.deepEqual(results.map((result) => result.rc), [0, 0]);
+        assert.equal(count(), 2);
+    });
+
+    test('rejects statements that are neither strings nor objects with sql', () => {
+        assert.throws(() => db.pipeline([42]), TypeError);
+        assert.throws(() => db.pipeline([{ select: true }]), TypeError);
+    });
+});
@@ -0,0 +1,86 @@
+import { describe, test, before, afterEach } from 'node:test';
+import assert from 'node:assert/strict';
+import { cubesql, connect, server, skip } from './server.js';
+
+describe('Pool', { skip }, () => {
+    let pool;
+
+    function open(options) {
+        pool = new cubesql.Pool({ ...server, ...options });
+        return pool;
+    }
+
+    before(async () => {
+        // creates the test database for the pooled connections
+        const db = await connect();
+        await db.disconnectAsync();
+    });
+
+    afterEach(() => {
+        pool?.close();
+        pool = undefined;
+    });
+
+    test('opens connections on demand and reuses released ones', async () => {
+        open({ min: 0, max: 2 });
+        assert.deepEqual(pool.stats(), { size: 0, idle: 0, opening: 0, waiting: 0, min: 0, max: 2 });
+
+        const db = await pool.acquire();
+        assert.ok(db instanceof cubesql.Database);
+        assert.equal(pool.stats().size, 1);
+        assert.equal(pool.stats().idle, 0);
+
+        pool.release(db);
+        assert.equal(pool.stats().idle, 1);
+        assert.equal(await pool.acquire(), db);
+        assert.equal(pool.stats().size, 1);
+        pool.release(db);
+    });
+
+    test('queues acquire calls beyond max until a connection is released', async () => {
+        open({ min: 0, max: 1 });
+        const first = await pool.acquire();
+        let second;
+        const waiting = pool.acquire().then((db) => { second = db; });
+        await new Promise((resolve) => setImmediate(resolve));
+        assert.equal(second, undefined);
+        assert.equal(pool.stats().waiting, 1);
+
+        pool.release(first);
+        await waiting;
+        assert.equal(second, first);
+        assert.equal(pool.stats().waiting, 0);
+        pool.release(second);
+    });
+
+    test('rejects releasing a connection that is not checked out', async () => {
+        open({ min: 0, max: 1 });
+        const db = await pool.acquire();
+        pool.release(db);
+        assert.throws(() => pool.release(db), /not checked out/);
+
+        const other = await connect();
+        assert.throws(() => pool.release(other), /not checked out/);
+        await other.disconnectAsync();
+    });
+
+    test('runs statements on pooled connections', async () => {
+        open({ min: 1, max: 2 });
+        await pool.open();
+        assert.equal(pool.stats().size, 1);
+        const cursors = await Promise.all([pool.selectAsync('SELECT 1'), pool.selectAsync('SELECT 2')]);
+        assert.deepEqual(cursors.map((cursor) => cursor.fetchAll()), [[['1']], [['2']]]);
+        cursors.forEach((cursor) => cursor.free());
+        await assert.rejects(async () => pool.selectAsync('SELECT 1', { serverSide: true }), TypeError);
+    });
+
+    test('rejects waiting and new acquire calls once closed', async () => {
+        open({ min: 0, max: 1 });
+        const db = await pool.acquire();
+        const waiting = pool.acquire();
+        pool.close();
+        await assert.rejects(waiting, /closed/);
+        await assert.rejects(pool.acquire(), /closed/);
+        pool.release(db);
+    });
+});
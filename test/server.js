@@ -0,0 +1,30 @@
+// Connection settings of the server the smoke tests run against. The tests are skipped when
+// CUBESQL_HOST is not set; the database is created unless it exists already.
+import { createRequire } from 'node:module';
+
+const require = createRequire(import.meta.url);
+export const cubesql = require('../build/Release/cubesql_addon.node');
+
+export const server = {
+    host: process.env.CUBESQL_HOST,
+    port: Number(process.env.CUBESQL_PORT ?? 4430),
+    username: process.env.CUBESQL_USERNAME ?? 'admin',
+    password: process.env.CUBESQL_PASSWORD ?? 'admin',
+    timeout: 10,
+    database: process.env.CUBESQL_DATABASE ?? 'cubesql_node_test.sqlite',
+};
+
+export const skip = server.host ? false : 'CUBESQL_HOST is not set';
+
+export async function connect() {
+    const db = await cubesql.connectAsync(server.host, server.port, server.username, server.password,
+                                          server.timeout, cubesql.CUBESQL_ENCRYPTION_NONE);
+    await db.executeAsync(`CREATE DATABASE ${server.database}`).catch(() => {});
+    await db.setDatabaseAsync(server.database);
+    return db;
+}
+
+// A table name of its own for every test process, so that concurrent runs do not collide
+export function tableName(prefix) {
+    return `${prefix}_${process.pid}`;
+}
@@ -1,20 +1,244 @@
 declare module 'cubesql.node' {
-    export interface Database {
-        dbPointer: any;
-        connect(host: string, port: number, username: string, password: string, timeout: number, encryption: number): any;
-        setDatabase(db: any, databaseName: string): void;
-        selectSQL(db: any, query: string): any;
-        getCursorField(cursor: any, fieldType: number, column: number): string;
-        getCursorFieldBuffer(cursor: any, fieldType: number, column: number): Buffer;
-        getCursorNumColumns(cursor: any): number;
-        isCursorEOF(cursor: any): boolean;
-        seekCursor(cursor: any, seekType: number): void;
-        freeCursor(cursor: any): void;
-        getErrorMessage(db: any): string;
+    // Handles are created by the connect, select and prepare calls; they cannot be constructed directly.
+    // Native resources are released on disconnect/free/close or when the object is garbage collected.
+    // serverSide keeps the result on the server and reads it row by row (numRows() is -1, only
+    // SEEKNEXT is supported); prefetch is the number of rows requested ahead, 64 by default and at most 512.
+    // compression overrides the result compression of the connection for this select.
+    export interface SelectOptions {
+        serverSide?: boolean;
+        prefetch?: number;
+        compression?: CompressionMode;
     }
 
-    export interface Cursor {
-        cursorPointer: any;
+    // Whether the server may compress its replies: 'auto' decides from the measured bandwidth,
+    // compression ratio and decompression speed. true and false are 'on' and 'off'.
+    export type CompressionMode = 'on' | 'off' | 'auto' | boolean;
+
+    export class Database {
+        private constructor();
+        execute(sql: string): number;
+        executeEx(sql: string): ExecuteExResult;
+        pipeline(statements: PipelineStatement[], options?: PipelineOptions): PipelineResult[];
+        select(sql: string, options?: SelectOptions): Cursor;
+        selectStream(sql: string, options?: { shape?: 'arrays' }): ResultStream<(string | Buffer | null)[]>;
+        selectStream(sql: string, options: { shape: 'objects' }): ResultStream<Record<string, string | Buffer | null>>;
+        commit(): number;
+        rollback(): number;
+        beginTransaction(): number;
+        bind(sql: string, values: BindValue[]): number;
+        bind(sql: string, colvalue: (string | Buffer)[], colsize: number[], coltype: number[], ncols: number): number;
+        ping(): number;
+        cancel(): void;
+        errorCode(): number;
+        errorMessage(): string;
+        changes(): number;
+        setTraceCallback(callback: (message: string) => void): void;
+        setDedicatedThread(enabled: boolean): void;
+        setStatementCache(capacity: number): void;
+        statementCacheStats(): StatementCacheStats;
+        setCompression(options: CompressionOptions): void;
+        compressionStats(): CompressionStats;
+        setResultCompression(mode: CompressionMode): void;
+        setDatabase(dbname: string): number;
+        affectedRows(): number;
+        lastInsertedRowID(): number;
+        sendData(buffer: Buffer, length: number): number;
+        sendEndData(): number;
+        receiveData(): { data: Buffer; isEndChunk: boolean };
+        prepare(sql: string): VM;
+        disconnect(): void;
+        executeAsync(sql: string): Promise<void>;
+        executeExAsync(sql: string): Promise<ExecuteExResult>;
+        pipelineAsync(statements: PipelineStatement[], options?: PipelineOptions): Promise<PipelineResult[]>;
+        selectAsync(sql: string, options?: SelectOptions): Promise<Cursor>;
+        prepareAsync(sql: string): Promise<VM>;
+        executeManyAsync(sql: string, rows: BindRows, options?: ExecuteManyOptions): Promise<ExecuteManyResult>;
+        setDatabaseAsync(dbname: string): Promise<void>;
+        disconnectAsync(): Promise<void>;
+        commitAsync(): Promise<void>;
+        rollbackAsync(): Promise<void>;
+        beginTransactionAsync(): Promise<void>;
+        pingAsync(): Promise<void>;
+        sendEndDataAsync(): Promise<void>;
+        changesAsync(): Promise<number>;
+        affectedRowsAsync(): Promise<number>;
+        lastInsertedRowIDAsync(): Promise<number>;
+        receiveDataAsync(): Promise<{ data: Buffer; isEndChunk: boolean } | null>;
+        bindAsync(sql: string, values: BindValue[]): Promise<void>;
+        bindAsync(sql: string, colvalue: (string | Buffer)[], colsize: number[], coltype: number[], ncols: number): Promise<void>;
+        sendDataAsync(buffer: Buffer, length: number): Promise<void>;
+    }
+
+    export class Cursor {
+        private constructor();
+        numRows(): number;
+        numColumns(): number;
+        currentRow(): number;
+        seek(index: number): number;
+        isEOF(): boolean;
+        columnType(index: number): number;
+        field(row: number, column: number): string;
+        fieldBuffer(row: number, column: number): Buffer;
+        rowID(row: number): number;
+        int64(row: number, column: number, defaultValue: number): number;
+        int(row: number, column: number, defaultValue: number): number;
+        double(row: number, column: number, defaultValue: number): number;
+        cstring(row: number, column: number): string;
+        cstringStatic(row: number, column: number, staticBuffer: Buffer): string;
+        free(): void;
+        fetchAll(options?: { shape?: 'arrays' }): (string | Buffer | null)[][];
+        fetchAll(options: { shape: 'objects' }): Record<string, string | Buffer | null>[];
+        fetchColumns(columns: number[]): { values: BigInt64Array | Int32Array | Float64Array; nulls: Uint8Array }[];
+    }
+
+    // Result of executeEx; changes and lastRowId are 0 when rc is an error
+    export interface ExecuteExResult {
+        rc: number;
+        changes: number;
+        lastRowId: number;
+    }
+
+    // A statement of pipeline: sql to execute, or { sql, select: true } for a select returning a cursor
+    export type PipelineStatement = string | { sql: string; select?: boolean };
+
+    export interface PipelineOptions {
+        transaction?: boolean;  // run all statements in one transaction, rolled back when one fails
+    }
+
+    // rc is CUBESQL_NOERR or the error code of the statement, message its error message
+    export interface PipelineResult {
+        rc: number;
+        message?: string;
+        cursor?: Cursor;
+    }
+
+    // Parameter values for bind, bindExecuteAsync / bindSelectAsync and bindSQL; typed arrays and ArrayBuffers are bound as blobs,
+    // NaN as NULL, and Infinity is rejected
+    export type BindValue = number | bigint | boolean | string | Buffer | ArrayBufferView | ArrayBuffer | null | undefined;
+
+    // Rows for executeMany: parameter arrays, or columns in parameter order (float NaN is bound as NULL, Infinity is rejected)
+    export type BindRows = BindValue[][] | { [column: string]: BindValue[] | Int8Array | Uint8Array | Int16Array | Uint16Array | Int32Array | Uint32Array | Float32Array | Float64Array | BigInt64Array | BigUint64Array };
+
+    export interface ExecuteManyOptions {
+        transaction?: boolean;  // run all rows in one transaction, rolled back on the first error
+        changes?: boolean;      // collect the changes of every row (default true)
+    }
+
+    export interface ExecuteManyResult {
+        rows: number;
+        changes?: number[];
+    }
+
+    export class VM {
+        private constructor();
+        bindInt(index: number, value: number): number;
+        bindDouble(index: number, value: number): number;
+        bindText(index: number, value: string): number;
+        bind(index: number, value: BindValue): number;
+        bindNull(index: number): number;
+        bindInt64(index: number, value: number): number;
+        bindZeroBlob(index: number, length: number): number;
+        execute(): number;
+        select(): Cursor;
+        close(): number;
+        bindIntAsync(index: number, value: number): Promise<void>;
+        bindDoubleAsync(index: number, value: number): Promise<void>;
+        bindTextAsync(index: number, value: string): Promise<void>;
+        bindAsync(index: number, value: BindValue): Promise<void>;
+        bindNullAsync(index: number): Promise<void>;
+        bindInt64Async(index: number, value: number): Promise<void>;
+        bindZeroBlobAsync(index: number, length: number): Promise<void>;
+        executeAsync(): Promise<void>;
+        selectAsync(): Promise<Cursor>;
+        closeAsync(): Promise<void>;
+        bindExecuteAsync(params: BindValue[]): Promise<void>;
+        bindSelectAsync(params: BindValue[]): Promise<Cursor>;
+        executeManyAsync(rows: BindRows, options?: ExecuteManyOptions): Promise<ExecuteManyResult>;
+    }
+
+    // Each iteration yields the rows of one chunk as soon as it has been received; the server sends
+    // the next chunk only when the next one is requested. Use Readable.from(stream) for a Node stream.
+    export class ResultStream<Row> implements AsyncIterableIterator<Row[]> {
+        private constructor();
+        next(): Promise<IteratorResult<Row[], undefined>>;
+        return(): Promise<IteratorResult<Row[], undefined>>;
+        [Symbol.asyncIterator](): ResultStream<Row>;
+    }
+
+    export interface StatementCacheStats {
+        capacity: number;
+        size: number;
+        hits: number;
+        misses: number;
+        evictions: number;
+        reprepares: number;  // statements prepared again on use because another one was prepared since
+    }
+
+    // Compression of the packets sent to the server. level is the zlib level (-1 the zlib default, 0 off),
+    // packets below minSize bytes (512 by default) are sent as they are, and statements also compresses
+    // the SQL of large statements, which requires a server that accepts compressed statements.
+    export interface CompressionOptions {
+        level?: number;
+        minSize?: number;
+        statements?: boolean;
+    }
+
+    // bytesIn and bytesOut are the sizes before and after compression, skipped counts the packets sent
+    // uncompressed because they were too small, looked incompressible or did not shrink.
+    export interface CompressionStats {
+        bytesIn: number;
+        bytesOut: number;
+        skipped: number;
+        results: ResultCompressionStats;
+    }
+
+    // Replies received from the server. Times are in milliseconds. inflateTimeSaved is the decompression
+    // time estimated to be saved by not advertising compression, bandwidth is in bytes per second.
+    export interface ResultCompressionStats {
+        compressed: number;
+        uncompressed: number;
+        bytesCompressed: number;
+        bytesExpanded: number;
+        bytesUncompressed: number;
+        inflateTime: number;
+        inflateTimeSaved: number;
+        bandwidth: number;
+        rtt: number;
+        advertising: boolean;
+    }
+
+    // Connections are opened on demand up to max and kept open down to min. pingAfter (ms, 30000 by default)
+    // is how long a connection may sit idle before it is pinged on checkout; idleTimeout (ms, 60000 by
+    // default) is how long a connection above min may sit idle before it is closed.
+    export interface PoolOptions {
+        host: string;
+        port?: number;
+        username?: string;
+        password?: string;
+        timeout?: number;
+        encryption?: number;
+        sslCertificatePath?: string;
+        database?: string;
+        min?: number;
+        max?: number;
+        pingAfter?: number;
+        idleTimeout?: number;
+        dedicatedThreads?: boolean;
+        statementCache?: number;
+        compression?: CompressionOptions;
+        resultCompression?: CompressionMode;
+    }
+
+    export class Pool {
+        constructor(options: PoolOptions);
+        open(): Promise<void>;
+        acquire(): Promise<Database>;
+        release(db: Database): void;
+        transaction(): Promise<Database>;
+        executeAsync(sql: string): Promise<void>;
+        selectAsync(sql: string, options?: SelectOptions): Promise<Cursor>;
+        close(): void;
+        stats(): { size: number; idle: number; opening: number; waiting: number; min: number; max: number };
     }
 
     export const CUBESQL_ENCRYPTION_NONE: number;
@@ -36,17 +260,26 @@ declare module 'cubesql.node' {
     export function connectToCubeSQLSSL(host: string, port: number, username: string, password: string, timeout: number, sslCertificatePath: string): Database;
     export function disconnectFromCubeSQL(db: Database): void;
     export function executeSQL(db: Database, sql: string): number;
-    export function selectSQL(db: Database, sql: string): Cursor;
+    export function executeEx(db: Database, sql: string): ExecuteExResult;
+    export function pipeline(db: Database, statements: PipelineStatement[], options?: PipelineOptions): PipelineResult[];
+    export function selectSQL(db: Database, sql: string, options?: SelectOptions): Cursor;
     export function commitTransaction(db: Database): number;
     export function rollbackTransaction(db: Database): number;
     export function beginTransaction(db: Database): number;
-    export function bindSQL(db: Database, sql: string, colvalue: string[], colsize: number[], coltype: number[], ncols: number): number;
+    export function bindSQL(db: Database, sql: string, values: BindValue[]): number;
+    export function bindSQL(db: Database, sql: string, colvalue: (string | Buffer)[], colsize: number[], coltype: number[], ncols: number): number;
     export function pingCubeSQL(db: Database): number;
     export function cancelCubeSQL(db: Database): void;
     export function getErrorCode(db: Database): number;
     export function getErrorMessage(db: Database): string;
     export function getChanges(db: Database): number;
     export function setTraceCallback(db: Database, callback: (message: string) => void): void;
+    export function setDedicatedThread(db: Database, enabled: boolean): void;
+    export function setStatementCache(db: Database, capacity: number): void;
+    export function getStatementCacheStats(db: Database): StatementCacheStats;
+    export function setCompression(db: Database, options: CompressionOptions): void;
+    export function getCompressionStats(db: Database): CompressionStats;
+    export function setResultCompression(db: Database, mode: CompressionMode): void;
     export function setDatabase(db: Database, dbname: string): number;
     export function getAffectedRows(db: Database): number;
     export function getLastInsertedRowID(db: Database): number;
@@ -54,16 +287,17 @@ declare module 'cubesql.node' {
     export function sendData(db: Database, buffer: Buffer, length: number): number;
     export function sendEndData(db: Database): number;
     export function receiveData(db: Database): { data: Buffer; isEndChunk: boolean };
-    export function prepareVM(db: Database, sql: string): any;
-    export function bindVMInt(vm: any, index: number, value: number): number;
-    export function bindVMDouble(vm: any, index: number, value: number): number;
-    export function bindVMText(vm: any, index: number, value: string): number;
-    export function bindVMNull(vm: any, index: number): number;
-    export function bindVMInt64(vm: any, index: number, value: number): number;
-    export function bindVMZeroBlob(vm: any, index: number, length: number): number;
-    export function executeVM(vm: any): number;
-    export function selectVM(vm: any): Cursor;
-    export function closeVM(vm: any): number;
+    export function prepareVM(db: Database, sql: string): VM;
+    export function bindVMInt(vm: VM, index: number, value: number): number;
+    export function bindVMDouble(vm: VM, index: number, value: number): number;
+    export function bindVMText(vm: VM, index: number, value: string): number;
+    export function bindVM(vm: VM, index: number, value: BindValue): number;
+    export function bindVMNull(vm: VM, index: number): number;
+    export function bindVMInt64(vm: VM, index: number, value: number): number;
+    export function bindVMZeroBlob(vm: VM, index: number, length: number): number;
+    export function executeVM(vm: VM): number;
+    export function selectVM(vm: VM): Cursor;
+    export function closeVM(vm: VM): number;
     export function getCursorNumRows(cursor: Cursor): number;
     export function getCursorNumColumns(cursor: Cursor): number;
     export function getCursorCurrentRow(cursor: Cursor): number;
@@ -79,4 +313,47 @@ declare module 'cubesql.node' {
     export function getCursorCString(cursor: Cursor, row: number, column: number): string;
     export function getCursorCStringStatic(cursor: Cursor, row: number, column: number, staticBuffer: Buffer): string;
     export function freeCursor(cursor: Cursor): void;
+    export function fetchAll(cursor: Cursor, options?: { shape?: 'arrays' }): (string | Buffer | null)[][];
+    export function fetchAll(cursor: Cursor, options: { shape: 'objects' }): Record<string, string | Buffer | null>[];
+    export function selectStream(db: Database, sql: string, options?: { shape?: 'arrays' }): ResultStream<(string | Buffer | null)[]>;
+    export function selectStream(db: Database, sql: string, options: { shape: 'objects' }): ResultStream<Record<string, string | Buffer | null>>;
+    export function fetchColumns(cursor: Cursor, columns: number[]): { values: BigInt64Array | Int32Array | Float64Array; nulls: Uint8Array }[];
+
+    // Promise-based variants: the round trip runs off the event loop, calls on the same
+    // connection run one at a time, failures reject with an Error whose code is the SDK error code
+    export function connectAsync(host: string, port: number, username: string, password: string, timeout: number, encryption: number): Promise<Database>;
+    export function connectSSLAsync(host: string, port: number, username: string, password: string, timeout: number, sslCertificatePath: string): Promise<Database>;
+    export function disconnectAsync(db: Database): Promise<void>;
+    export function executeAsync(db: Database, sql: string): Promise<void>;
+    export function executeExAsync(db: Database, sql: string): Promise<ExecuteExResult>;
+    export function pipelineAsync(db: Database, statements: PipelineStatement[], options?: PipelineOptions): Promise<PipelineResult[]>;
+    export function selectAsync(db: Database, sql: string, options?: SelectOptions): Promise<Cursor>;
+    export function commitAsync(db: Database): Promise<void>;
+    export function rollbackAsync(db: Database): Promise<void>;
+    export function beginTransactionAsync(db: Database): Promise<void>;
+    export function bindAsync(db: Database, sql: string, values: BindValue[]): Promise<void>;
+    export function bindAsync(db: Database, sql: string, colvalue: (string | Buffer)[], colsize: number[], coltype: number[], ncols: number): Promise<void>;
+    export function pingAsync(db: Database): Promise<void>;
+    export function setDatabaseAsync(db: Database, dbname: string): Promise<void>;
+    export function getChangesAsync(db: Database): Promise<number>;
+    export function getAffectedRowsAsync(db: Database): Promise<number>;
+    export function getLastInsertedRowIDAsync(db: Database): Promise<number>;
+    export function sendDataAsync(db: Database, buffer: Buffer, length: number): Promise<void>;
+    export function sendEndDataAsync(db: Database): Promise<void>;
+    export function receiveDataAsync(db: Database): Promise<{ data: Buffer; isEndChunk: boolean } | null>;
+    export function prepareAsync(db: Database, sql: string): Promise<VM>;
+    export function executeManyAsync(db: Database, sql: string, rows: BindRows, options?: ExecuteManyOptions): Promise<ExecuteManyResult>;
+    export function bindVMIntAsync(vm: VM, index: number, value: number): Promise<void>;
+    export function bindVMDoubleAsync(vm: VM, index: number, value: number): Promise<void>;
+    export function bindVMTextAsync(vm: VM, index: number, value: string): Promise<void>;
+    export function bindVMAsync(vm: VM, index: number, value: BindValue): Promise<void>;
+    export function bindVMNullAsync(vm: VM, index: number): Promise<void>;
+    export function bindVMInt64Async(vm: VM, index: number, value: number): Promise<void>;
+    export function bindVMZeroBlobAsync(vm: VM, index: number, length: number): Promise<void>;
+    export function executeVMAsync(vm: VM): Promise<void>;
+    export function selectVMAsync(vm: VM): Promise<Cursor>;
+    export function closeVMAsync(vm: VM): Promise<void>;
+    export function bindExecuteVMAsync(vm: VM, params: BindValue[]): Promise<void>;
+    export function bindSelectVMAsync(vm: VM, params: BindValue[]): Promise<Cursor>;
+    export function executeManyVMAsync(vm: VM, rows: BindRows, options?: ExecuteManyOptions): Promise<ExecuteManyResult>;
 }
\ No newline at end of file